@@ -0,0 +1,95 @@
+/*******************************************************************************
+ * This file is part of the "https://github.com/blackmatov/promise.hpp"
+ * For conditions of distribution and use, see copyright notice in LICENSE.md
+ * Copyright (C) 2018-2023, by Matvey Cherevko (blackmatov@gmail.com)
+ ******************************************************************************/
+
+#include <promise.hpp/promise.hpp>
+
+#include <cstdio>
+#include <thread>
+#include <vector>
+#include <chrono>
+
+namespace pr = promise_hpp;
+
+namespace
+{
+    const std::size_t thread_counts[] = {1, 2, 4, 8, 16, 32, 64};
+
+    template < typename F >
+    double measure_ms(std::size_t threads, F&& f) {
+        std::vector<std::thread> workers;
+        workers.reserve(threads);
+        const auto start = std::chrono::steady_clock::now();
+        for ( std::size_t t = 0; t < threads; ++t ) {
+            workers.emplace_back(f, t);
+        }
+        for ( std::thread& w : workers ) {
+            w.join();
+        }
+        const auto finish = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::milli>(finish - start).count();
+    }
+
+    double single_counter_ms(std::size_t threads, std::size_t count) {
+        std::atomic_size_t counter{count};
+        std::atomic_size_t finished{0u};
+        const double ms = measure_ms(threads, [&](std::size_t t){
+            for ( std::size_t i = t; i < count; i += threads ) {
+                if ( counter.fetch_sub(1u, std::memory_order_acq_rel) == 1u ) {
+                    ++finished;
+                }
+            }
+        });
+        return finished == 1u ? ms : -1.0;
+    }
+
+    double sharded_counter_ms(std::size_t threads, std::size_t count) {
+        pr::detail::sharded_countdown counter{count};
+        std::atomic_size_t finished{0u};
+        const double ms = measure_ms(threads, [&](std::size_t t){
+            for ( std::size_t i = t; i < count; i += threads ) {
+                if ( counter.count_down(i) ) {
+                    ++finished;
+                }
+            }
+        });
+        return finished == 1u ? ms : -1.0;
+    }
+
+    double make_all_promise_ms(std::size_t threads, std::size_t count) {
+        std::vector<pr::promise<int>> promises(count);
+        auto result = pr::make_all_promise(promises);
+        const double ms = measure_ms(threads, [&](std::size_t t){
+            for ( std::size_t i = t; i < count; i += threads ) {
+                promises[i].resolve(static_cast<int>(i));
+            }
+        });
+        return result.get().size() == count ? ms : -1.0;
+    }
+}
+
+int main() {
+    const std::size_t counter_count = 1u << 22;
+    const std::size_t promise_count = 100000u;
+
+    std::printf("fan-in countdown, %zu completions\n", counter_count);
+    std::printf("%8s %16s %16s\n", "threads", "single (ms)", "sharded (ms)");
+    for ( std::size_t threads : thread_counts ) {
+        std::printf("%8zu %16.2f %16.2f\n",
+            threads,
+            single_counter_ms(threads, counter_count),
+            sharded_counter_ms(threads, counter_count));
+    }
+
+    std::printf("\nmake_all_promise, %zu inputs\n", promise_count);
+    std::printf("%8s %16s\n", "threads", "resolve (ms)");
+    for ( std::size_t threads : thread_counts ) {
+        std::printf("%8zu %16.2f\n",
+            threads,
+            make_all_promise_ms(threads, promise_count));
+    }
+
+    return 0;
+}
@@ -0,0 +1,105 @@
+/*******************************************************************************
+ * This file is part of the "https://github.com/blackmatov/promise.hpp"
+ * For conditions of distribution and use, see copyright notice in LICENSE.md
+ * Copyright (C) 2018-2023, by Matvey Cherevko (blackmatov@gmail.com)
+ ******************************************************************************/
+
+#include <promise.hpp/bonus/jobber.hpp>
+
+#include <cstdio>
+#include <vector>
+#include <chrono>
+#include <thread>
+
+namespace jb = jobber_hpp;
+
+namespace
+{
+    template < typename F >
+    double measure_ms(F&& f) {
+        const auto start = std::chrono::steady_clock::now();
+        f();
+        const auto finish = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::milli>(finish - start).count();
+    }
+
+    // posts one task at a time after a short pause, so that the workers
+    // have gone idle, and measures the time until the task starts
+
+    double dispatch_latency_us(const jb::jobber_options& options) {
+        const std::size_t round_count = 2000u;
+        jb::jobber j(4u, options);
+        std::atomic<bool> started{false};
+        double total_us = 0.0;
+        for ( std::size_t i = 0; i < round_count; ++i ) {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+            started.store(false);
+            const auto start = std::chrono::steady_clock::now();
+            j.post([&started](){
+                started.store(true);
+            });
+            while ( !started.load() ) {
+                std::this_thread::yield();
+            }
+            const auto finish = std::chrono::steady_clock::now();
+            total_us += std::chrono::duration<double, std::micro>(finish - start).count();
+            j.wait_all();
+        }
+        return total_us / static_cast<double>(round_count);
+    }
+}
+
+int main() {
+    const std::size_t task_count = 200000u;
+    const std::size_t thread_counts[] = {1u, 8u, 64u};
+
+    std::printf("short tasks, %zu per run\n", task_count);
+    std::printf("%8s %14s %14s %14s\n", "threads", "mode", "total (ms)", "ns/task");
+    for ( std::size_t threads : thread_counts ) {
+        for ( bool work_stealing : {false, true} ) {
+            jb::jobber_options options;
+            options.work_stealing = work_stealing;
+            jb::jobber j(threads, options);
+            std::atomic<std::size_t> counter{0u};
+
+            const double total_ms = measure_ms([&](){
+                for ( std::size_t i = 0; i < task_count; ++i ) {
+                    j.post([&counter](){
+                        counter.fetch_add(1u, std::memory_order_relaxed);
+                    });
+                }
+                j.wait_all();
+            });
+
+            std::printf("%8zu %14s %14.2f %14.1f\n",
+                threads,
+                work_stealing ? "stealing" : "shared",
+                total_ms,
+                total_ms * 1e6 / static_cast<double>(task_count));
+
+            if ( counter != task_count ) {
+                std::printf("unexpected task count: %zu\n", counter.load());
+                return 1;
+            }
+        }
+    }
+
+    std::printf("\ndispatch latency, 4 threads\n");
+    std::printf("%14s %14s %14s\n", "mode", "idle", "latency (us)");
+    for ( bool work_stealing : {false, true} ) {
+        for ( bool spin : {false, true} ) {
+            jb::jobber_options options;
+            options.work_stealing = work_stealing;
+            if ( spin ) {
+                options.idle_strategy.spin_count = 4000u;
+                options.idle_strategy.yield_count = 100u;
+            }
+            std::printf("%14s %14s %14.2f\n",
+                work_stealing ? "stealing" : "shared",
+                spin ? "spin+park" : "park",
+                dispatch_latency_us(options));
+        }
+    }
+
+    return 0;
+}
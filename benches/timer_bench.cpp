@@ -0,0 +1,62 @@
+/*******************************************************************************
+ * This file is part of the "https://github.com/blackmatov/promise.hpp"
+ * For conditions of distribution and use, see copyright notice in LICENSE.md
+ * Copyright (C) 2018-2023, by Matvey Cherevko (blackmatov@gmail.com)
+ ******************************************************************************/
+
+#include <promise.hpp/bonus/timer.hpp>
+
+#include <cstdio>
+#include <vector>
+#include <chrono>
+
+namespace ti = timer_hpp;
+
+namespace
+{
+    template < typename F >
+    double measure_ms(F&& f) {
+        const auto start = std::chrono::steady_clock::now();
+        f();
+        const auto finish = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::milli>(finish - start).count();
+    }
+}
+
+int main() {
+    const std::size_t counts[] = {1000u, 10000u, 100000u};
+
+    std::printf("with_timeout, deadlines resolved before expiry\n");
+    std::printf("%10s %16s %16s %16s\n", "deadlines", "attach (ms)", "resolve (ms)", "ns/deadline");
+    for ( std::size_t count : counts ) {
+        ti::timer_wheel wheel;
+        std::vector<ti::promise<int>> ps(count);
+        std::vector<ti::promise<int>> rs;
+        rs.reserve(count);
+
+        const double attach_ms = measure_ms([&](){
+            for ( std::size_t i = 0; i < count; ++i ) {
+                rs.push_back(ti::with_timeout(ps[i], std::chrono::seconds(10 + i % 100), wheel));
+            }
+        });
+
+        const double resolve_ms = measure_ms([&](){
+            for ( std::size_t i = 0; i < count; ++i ) {
+                ps[i].resolve(static_cast<int>(i));
+            }
+        });
+
+        std::printf("%10zu %16.2f %16.2f %16.1f\n",
+            count,
+            attach_ms,
+            resolve_ms,
+            (attach_ms + resolve_ms) * 1e6 / static_cast<double>(count));
+
+        if ( wheel.timer_count() != 0u ) {
+            std::printf("unexpected pending timers: %zu\n", wheel.timer_count());
+            return 1;
+        }
+    }
+
+    return 0;
+}
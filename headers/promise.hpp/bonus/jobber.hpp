@@ -8,8 +8,20 @@
 
 #include "../promise.hpp"
 
+#include <random>
+#include <string>
+#include <fstream>
 #include <algorithm>
 
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#  include <intrin.h>
+#endif
+
+#if defined(__linux__)
+#  include <sched.h>
+#  include <pthread.h>
+#endif
+
 namespace jobber_hpp
 {
     using namespace promise_hpp;
@@ -34,9 +46,48 @@ namespace jobber_hpp
         : std::runtime_error("jobber has stopped working") {}
     };
 
+    // receives exceptions escaping posted tasks, invoked on the thread
+    // that ran the task and must not throw, without a handler such
+    // exceptions are dropped
+
+    using jobber_error_handler = std::function<void(std::exception_ptr)>;
+
+    // an idle worker polls for new tasks 'spin_count' times, then
+    // yields 'yield_count' times and only then parks on the condition
+    // variable, spinning trades cpu time for lower dispatch latency
+
+    struct jobber_idle_strategy {
+        std::size_t spin_count{0u};
+        std::size_t yield_count{0u};
+    };
+
+    // the jobber starts another worker, up to 'max_threads', when the shared
+    // queue has not been drained for 'max_queue_delay' and no worker is idle,
+    // workers above the minimum stop after 'idle_timeout' without tasks
+
+    struct jobber_elasticity {
+        std::size_t max_threads{0u};
+        std::chrono::microseconds max_queue_delay{1000};
+        std::chrono::milliseconds idle_timeout{5000};
+    };
+
+    struct jobber_options {
+        // every worker owns a local deque, tasks spawned by a worker with
+        // the normal priority go to its deque, other tasks go to the shared
+        // priority queue and idle workers steal from random victims
+        bool work_stealing{false};
+        jobber_error_handler error_handler;
+        jobber_idle_strategy idle_strategy;
+        jobber_elasticity elasticity;
+        // worker 'i' is pinned to the cpus of 'cpu_sets[i % cpu_sets.size()]',
+        // pinning is best effort and is only supported on linux, in the
+        // work stealing mode workers of the same set steal from each other first
+        std::vector<std::vector<std::size_t>> cpu_sets;
+    };
+
     class jobber final : private detail::noncopyable {
     public:
-        explicit jobber(std::size_t threads);
+        explicit jobber(std::size_t threads, const jobber_options& options = jobber_options());
         ~jobber() noexcept;
 
         using active_wait_result_t = std::pair<
@@ -56,10 +107,53 @@ namespace jobber_hpp
                  , typename R = async_invoke_result_t<F, Args...> >
         promise<R> async(jobber_priority priority, F&& f, Args&&... args);
 
+        template < typename Iter, typename F >
+        using bulk_invoke_result_t = std::invoke_result_t<
+            std::decay_t<F>&,
+            typename std::iterator_traits<Iter>::value_type>;
+
+        template < typename Iter >
+        using bulk_callable_result_t = std::invoke_result_t<
+            std::decay_t<typename std::iterator_traits<Iter>::value_type>>;
+
+        // submits one task per element under a single lock acquisition,
+        // 'f' is shared between the tasks and may be called concurrently
+
+        template < typename Iter, typename F
+                 , typename R = bulk_invoke_result_t<Iter, F> >
+        std::vector<promise<R>> async_bulk(Iter begin, Iter end, F&& f);
+
+        template < typename Iter, typename F
+                 , typename R = bulk_invoke_result_t<Iter, F> >
+        std::vector<promise<R>> async_bulk(jobber_priority priority, Iter begin, Iter end, F&& f);
+
+        template < typename Iter
+                 , typename R = bulk_callable_result_t<Iter> >
+        std::vector<promise<R>> async_bulk(Iter begin, Iter end);
+
+        template < typename Iter
+                 , typename R = bulk_callable_result_t<Iter> >
+        std::vector<promise<R>> async_bulk(jobber_priority priority, Iter begin, Iter end);
+
+        template < typename F, typename... Args
+                 , typename R = async_invoke_result_t<F, Args...> >
+        void post(F&& f, Args&&... args);
+
+        template < typename F, typename... Args
+                 , typename R = async_invoke_result_t<F, Args...> >
+        void post(jobber_priority priority, F&& f, Args&&... args);
+
         void pause() noexcept;
         void resume() noexcept;
         bool is_paused() const noexcept;
 
+        // sets the minimum number of workers and starts or stops workers to
+        // match it, busy workers stop after their current task, in the work
+        // stealing mode once their local deque is drained too, and the count
+        // is limited by the one given at construction
+
+        void resize(std::size_t threads);
+
         std::size_t thread_count() const noexcept;
         std::thread::id thread_id(std::size_t i) const;
         std::vector<std::thread::id> thread_ids() const;
@@ -68,6 +162,17 @@ namespace jobber_hpp
         active_wait_result_t active_wait_all() noexcept;
         active_wait_result_t active_wait_one() noexcept;
 
+        // without queued tasks waits until a task is queued or 'pred'
+        // returns true and then behaves like 'active_wait_one', 'pred' is
+        // called under the jobber lock, so the state it checks has to be
+        // changed by 'notify_waiters'
+
+        template < typename Pred >
+        active_wait_result_t active_wait_one_unless(Pred&& pred);
+
+        template < typename F >
+        void notify_waiters(F&& f);
+
         template < typename Rep, typename Period >
         jobber_wait_status wait_all_for(
             const std::chrono::duration<Rep, Period>& timeout_duration) const;
@@ -84,31 +189,75 @@ namespace jobber_hpp
         active_wait_result_t active_wait_all_until(
             const std::chrono::time_point<Clock, Duration>& timeout_time);
     private:
-        class task;
+        using task = detail::pooled_task;
         using task_ptr = std::unique_ptr<task>;
         template < typename R, typename F, typename... Args >
         class concrete_task;
+        template < typename F, typename... Args >
+        using posted_task = detail::posted_task<F, Args...>;
+        using task_queue = detail::priority_task_queue<jobber_priority, task_ptr>;
+        class task_deque;
+        using task_deque_ptr = std::unique_ptr<task_deque>;
     private:
-        void push_task_(jobber_priority priority, task_ptr task);
+        void enqueue_task_(jobber_priority priority, task_ptr task);
+        void enqueue_tasks_(jobber_priority priority, std::vector<task_ptr> tasks);
+        void push_task_(jobber_priority priority, task_ptr task, std::vector<std::thread>& retired_threads);
         task_ptr pop_task_() noexcept;
         void shutdown_() noexcept;
-        void worker_main_() noexcept;
-        void process_task_(std::unique_lock<std::mutex> lock) noexcept;
+        void worker_main_(std::size_t slot) noexcept;
+        bool process_task_(std::unique_lock<std::mutex> lock) noexcept;
+        void spawn_worker_locked_(std::vector<std::thread>& retired_threads);
+        void retire_worker_locked_(std::size_t slot) noexcept;
+        void take_retired_threads_locked_(std::vector<std::thread>& retired_threads);
+        static void join_threads_(std::vector<std::thread>& threads) noexcept;
+        void note_backlog_locked_() noexcept;
+        void grow_if_backlogged_locked_(std::vector<std::thread>& retired_threads) noexcept;
+    private:
+        struct worker_context {
+            const jobber* owner{nullptr};
+            std::size_t index{0u};
+        };
+        static worker_context& current_worker_() noexcept;
+        void push_local_task_(std::size_t index, task_ptr task);
+        void wake_sleeping_workers_(std::size_t count) noexcept;
+        void wake_worker_locked_() noexcept;
+        static void cpu_relax_() noexcept;
+        bool has_pending_work_() const noexcept;
+        void idle_spin_() const noexcept;
+        template < typename Pred >
+        bool park_worker_(std::unique_lock<std::mutex>& lock, Pred&& pred) noexcept;
+        task_ptr pop_local_task_(std::size_t index) noexcept;
+        task_ptr pop_global_task_() noexcept;
+        task_ptr steal_task_(std::size_t thief) noexcept;
+        bool has_stealing_work_() const noexcept;
+        void finish_task_() noexcept;
+        void stealing_worker_main_(std::size_t index) noexcept;
     private:
         std::vector<std::thread> threads_;
-        std::vector<std::pair<jobber_priority, task_ptr>> tasks_;
+        std::vector<std::thread> retired_threads_;
+        task_queue tasks_;
+        std::vector<task_deque_ptr> deques_;
+        std::vector<std::size_t> worker_groups_;
         std::atomic<bool> paused_{false};
         std::atomic<bool> cancelled_{false};
         std::atomic<std::size_t> active_task_count_{0};
+        std::atomic<std::size_t> global_task_count_{0};
+        std::atomic<std::size_t> sleeping_worker_count_{0};
+        std::atomic<std::size_t> live_thread_count_{0};
+        const bool work_stealing_;
+        const jobber_error_handler error_handler_;
+        const jobber_idle_strategy idle_strategy_;
+        const jobber_elasticity elasticity_;
+        const std::vector<std::vector<std::size_t>> cpu_sets_;
         mutable std::mutex tasks_mutex_;
-        mutable std::condition_variable cond_var_;
-    };
-
-    class jobber::task : private detail::noncopyable {
-    public:
-        virtual ~task() noexcept = default;
-        virtual void run() noexcept = 0;
-        virtual void cancel() noexcept = 0;
+        std::size_t active_waiter_count_{0u};
+        std::size_t pending_wakeups_{0u};
+        std::size_t min_threads_{0u};
+        std::size_t max_threads_{0u};
+        std::atomic<std::size_t> retire_request_count_{0u};
+        std::chrono::steady_clock::time_point backlog_since_;
+        mutable std::condition_variable worker_cond_var_;
+        mutable std::condition_variable waiter_cond_var_;
     };
 
     template < typename R, typename F, typename... Args >
@@ -121,6 +270,7 @@ namespace jobber_hpp
         concrete_task(U&& u, std::tuple<Args...>&& args);
         void run() noexcept final;
         void cancel() noexcept final;
+        bool is_cancelled() const noexcept final;
         promise<R> future() noexcept;
     };
 
@@ -134,17 +284,178 @@ namespace jobber_hpp
         concrete_task(U&& u, std::tuple<Args...>&& args);
         void run() noexcept final;
         void cancel() noexcept final;
+        bool is_cancelled() const noexcept final;
         promise<void> future() noexcept;
     };
+
+    // Chase-Lev deque, the owner pushes and pops at the bottom,
+    // thieves take from the top, outgrown buffers are kept alive
+    // until destruction because thieves may still read from them
+
+    class jobber::task_deque final : private detail::noncopyable {
+    public:
+        explicit task_deque(std::size_t capacity = 64u);
+        ~task_deque() noexcept;
+
+        void push(task* t);
+        task* pop() noexcept;
+        task* steal() noexcept;
+        bool empty() const noexcept;
+    private:
+        struct buffer final {
+            const std::int64_t mask;
+            std::unique_ptr<std::atomic<task*>[]> slots;
+
+            explicit buffer(std::size_t capacity)
+            : mask(static_cast<std::int64_t>(capacity) - 1)
+            , slots(std::make_unique<std::atomic<task*>[]>(capacity)) {}
+
+            std::int64_t capacity() const noexcept {
+                return mask + 1;
+            }
+
+            task* get(std::int64_t i) const noexcept {
+                return slots[static_cast<std::size_t>(i & mask)].load(std::memory_order_relaxed);
+            }
+
+            void put(std::int64_t i, task* t) noexcept {
+                slots[static_cast<std::size_t>(i & mask)].store(t, std::memory_order_relaxed);
+            }
+        };
+        buffer* grow_(buffer* old, std::int64_t bottom, std::int64_t top);
+    private:
+        std::atomic<std::int64_t> top_{0};
+        std::atomic<std::int64_t> bottom_{0};
+        std::atomic<buffer*> buffer_{nullptr};
+        std::vector<std::unique_ptr<buffer>> buffers_;
+    };
 }
 
 namespace jobber_hpp
 {
-    inline jobber::jobber(std::size_t threads) {
+    namespace impl
+    {
+        // parses the linux cpu list format, e.g. "0-3,8,10-11"
+
+        inline std::vector<std::size_t> parse_cpu_list(const std::string& list) {
+            std::vector<std::size_t> cpus;
+            std::size_t pos = 0;
+            while ( pos < list.size() ) {
+                std::size_t end = list.find(',', pos);
+                if ( end == std::string::npos ) {
+                    end = list.size();
+                }
+                const std::string range = list.substr(pos, end - pos);
+                const std::size_t dash = range.find('-');
+                try {
+                    const std::size_t first = std::stoul(range.substr(0, dash));
+                    const std::size_t last = dash == std::string::npos
+                        ? first
+                        : std::stoul(range.substr(dash + 1u));
+                    for ( std::size_t cpu = first; cpu <= last; ++cpu ) {
+                        cpus.push_back(cpu);
+                    }
+                } catch (const std::logic_error&) {
+                    return {};
+                }
+                pos = end + 1u;
+            }
+            return cpus;
+        }
+
+        inline std::vector<std::size_t> read_cpu_list(const std::string& path) {
+            std::ifstream file(path);
+            std::string list;
+            if ( !file || !std::getline(file, list) ) {
+                return {};
+            }
+            return parse_cpu_list(list);
+        }
+
+        inline bool pin_thread(std::thread& thread, const std::vector<std::size_t>& cpus) noexcept {
+        #if defined(__linux__)
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            for ( std::size_t cpu : cpus ) {
+                if ( cpu < CPU_SETSIZE ) {
+                    CPU_SET(cpu, &set);
+                }
+            }
+            return !cpus.empty()
+                && 0 == pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+        #else
+            (void)thread;
+            (void)cpus;
+            return false;
+        #endif
+        }
+    }
+
+    //
+    // cpu sets
+    //
+
+    // cpu sets of the online physical cores and numa nodes of the machine,
+    // empty when the topology is unknown, see 'jobber_options::cpu_sets'
+
+    inline std::vector<std::vector<std::size_t>> physical_core_cpu_sets() {
+        std::vector<std::vector<std::size_t>> sets;
+        for ( std::size_t cpu : impl::read_cpu_list("/sys/devices/system/cpu/online") ) {
+            std::vector<std::size_t> siblings = impl::read_cpu_list(
+                "/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/thread_siblings_list");
+            if ( siblings.empty() ) {
+                siblings.push_back(cpu);
+            }
+            if ( std::find(sets.begin(), sets.end(), siblings) == sets.end() ) {
+                sets.push_back(std::move(siblings));
+            }
+        }
+        return sets;
+    }
+
+    inline std::vector<std::vector<std::size_t>> numa_node_cpu_sets() {
+        std::vector<std::vector<std::size_t>> sets;
+        for ( std::size_t node : impl::read_cpu_list("/sys/devices/system/node/online") ) {
+            std::vector<std::size_t> cpus = impl::read_cpu_list(
+                "/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+            if ( !cpus.empty() ) {
+                sets.push_back(std::move(cpus));
+            }
+        }
+        return sets;
+    }
+}
+
+namespace jobber_hpp
+{
+    inline jobber::jobber(std::size_t threads, const jobber_options& options)
+    : work_stealing_(options.work_stealing)
+    , error_handler_(options.error_handler)
+    , idle_strategy_(options.idle_strategy)
+    , elasticity_(options.elasticity)
+    , cpu_sets_(options.cpu_sets)
+    , min_threads_(threads)
+    , max_threads_(std::max(threads, options.elasticity.max_threads)) {
         try {
-            threads_.resize(threads);
-            for ( std::thread& thread : threads_ ) {
-                thread = std::thread(&jobber::worker_main_, this);
+            // local deques are read by thieves without the lock,
+            // so every worker slot gets its deque up front
+            if ( work_stealing_ ) {
+                deques_.reserve(max_threads_);
+                for ( std::size_t i = 0; i < max_threads_; ++i ) {
+                    deques_.push_back(std::make_unique<task_deque>());
+                }
+            }
+            if ( work_stealing_ && !cpu_sets_.empty() ) {
+                worker_groups_.reserve(max_threads_);
+                for ( std::size_t i = 0; i < max_threads_; ++i ) {
+                    worker_groups_.push_back(i % cpu_sets_.size());
+                }
+            }
+            std::vector<std::thread> retired_threads;
+            std::lock_guard<std::mutex> guard(tasks_mutex_);
+            threads_.reserve(threads);
+            for ( std::size_t i = 0; i < threads; ++i ) {
+                spawn_worker_locked_(retired_threads);
             }
         } catch (...) {
             shutdown_();
@@ -174,47 +485,165 @@ namespace jobber_hpp
             std::forward<F>(f),
             std::make_tuple(std::forward<Args>(args)...));
         promise<R> future = task->future();
-        std::lock_guard<std::mutex> guard(tasks_mutex_);
-        push_task_(priority, std::move(task));
+        enqueue_task_(priority, std::move(task));
         return future;
     }
 
+    template < typename Iter, typename F, typename R >
+    std::vector<promise<R>> jobber::async_bulk(Iter begin, Iter end, F&& f) {
+        return async_bulk(
+            jobber_priority::normal,
+            begin,
+            end,
+            std::forward<F>(f));
+    }
+
+    template < typename Iter, typename F, typename R >
+    std::vector<promise<R>> jobber::async_bulk(jobber_priority priority, Iter begin, Iter end, F&& f) {
+        using value_t = typename std::iterator_traits<Iter>::value_type;
+        auto shared_f = std::make_shared<std::decay_t<F>>(std::forward<F>(f));
+        auto invoker = [shared_f](value_t&& v) -> R {
+            return std::invoke(*shared_f, std::move(v));
+        };
+        using task_t = concrete_task<
+            R,
+            decltype(invoker),
+            value_t>;
+        std::vector<task_ptr> tasks;
+        std::vector<promise<R>> futures;
+        const std::size_t count = static_cast<std::size_t>(std::distance(begin, end));
+        tasks.reserve(count);
+        futures.reserve(count);
+        for ( Iter iter = begin; iter != end; ++iter ) {
+            std::unique_ptr<task_t> task = std::make_unique<task_t>(
+                invoker,
+                std::tuple<value_t>(*iter));
+            futures.push_back(task->future());
+            tasks.push_back(std::move(task));
+        }
+        enqueue_tasks_(priority, std::move(tasks));
+        return futures;
+    }
+
+    template < typename Iter, typename R >
+    std::vector<promise<R>> jobber::async_bulk(Iter begin, Iter end) {
+        return async_bulk(
+            jobber_priority::normal,
+            begin,
+            end);
+    }
+
+    template < typename Iter, typename R >
+    std::vector<promise<R>> jobber::async_bulk(jobber_priority priority, Iter begin, Iter end) {
+        using task_t = concrete_task<
+            R,
+            std::decay_t<typename std::iterator_traits<Iter>::value_type>>;
+        std::vector<task_ptr> tasks;
+        std::vector<promise<R>> futures;
+        const std::size_t count = static_cast<std::size_t>(std::distance(begin, end));
+        tasks.reserve(count);
+        futures.reserve(count);
+        for ( Iter iter = begin; iter != end; ++iter ) {
+            std::unique_ptr<task_t> task = std::make_unique<task_t>(
+                *iter,
+                std::tuple<>());
+            futures.push_back(task->future());
+            tasks.push_back(std::move(task));
+        }
+        enqueue_tasks_(priority, std::move(tasks));
+        return futures;
+    }
+
+    template < typename F, typename... Args, typename R >
+    void jobber::post(F&& f, Args&&... args) {
+        post(
+            jobber_priority::normal,
+            std::forward<F>(f),
+            std::forward<Args>(args)...);
+    }
+
+    template < typename F, typename... Args, typename R >
+    void jobber::post(jobber_priority priority, F&& f, Args&&... args) {
+        using task_t = posted_task<
+            std::decay_t<F>,
+            std::decay_t<Args>...>;
+        enqueue_task_(priority, std::make_unique<task_t>(
+            &error_handler_,
+            std::forward<F>(f),
+            std::make_tuple(std::forward<Args>(args)...)));
+    }
+
     inline void jobber::pause() noexcept {
         std::lock_guard<std::mutex> guard(tasks_mutex_);
         paused_.store(true);
-        cond_var_.notify_all();
+        worker_cond_var_.notify_all();
     }
 
     inline void jobber::resume() noexcept {
         std::lock_guard<std::mutex> guard(tasks_mutex_);
         paused_.store(false);
-        cond_var_.notify_all();
+        worker_cond_var_.notify_all();
     }
 
     inline bool jobber::is_paused() const noexcept {
         return paused_;
     }
 
+    inline void jobber::resize(std::size_t threads) {
+        std::vector<std::thread> retired_threads;
+        try {
+            std::lock_guard<std::mutex> guard(tasks_mutex_);
+            if ( cancelled_ ) {
+                return;
+            }
+            if ( work_stealing_ ) {
+                threads = std::min(threads, deques_.size());
+            }
+            min_threads_ = threads;
+            max_threads_ = std::max(threads, elasticity_.max_threads);
+            if ( work_stealing_ ) {
+                max_threads_ = std::min(max_threads_, deques_.size());
+            }
+            retire_request_count_ = live_thread_count_ > threads
+                ? live_thread_count_ - threads
+                : 0u;
+            if ( retire_request_count_ ) {
+                worker_cond_var_.notify_all();
+            }
+            take_retired_threads_locked_(retired_threads);
+            while ( live_thread_count_ < threads ) {
+                spawn_worker_locked_(retired_threads);
+            }
+        } catch (...) {
+            join_threads_(retired_threads);
+            throw;
+        }
+        join_threads_(retired_threads);
+    }
+
     inline std::size_t jobber::thread_count() const noexcept {
-        return threads_.size();
+        return live_thread_count_;
     }
 
     inline std::thread::id jobber::thread_id(std::size_t i) const {
-        return threads_[i].get_id();
+        return thread_ids().at(i);
     }
 
     inline std::vector<std::thread::id> jobber::thread_ids() const {
+        std::lock_guard<std::mutex> guard(tasks_mutex_);
         std::vector<std::thread::id> ids;
         ids.reserve(threads_.size());
         for ( const std::thread& t : threads_ ) {
-            ids.push_back(t.get_id());
+            if ( t.joinable() ) {
+                ids.push_back(t.get_id());
+            }
         }
         return ids;
     }
 
     inline jobber_wait_status jobber::wait_all() const noexcept {
         std::unique_lock<std::mutex> lock(tasks_mutex_);
-        cond_var_.wait(lock, [this](){
+        waiter_cond_var_.wait(lock, [this](){
             return cancelled_ || !active_task_count_;
         });
         return cancelled_
@@ -226,11 +655,12 @@ namespace jobber_hpp
         std::size_t processed_tasks = 0;
         while ( !cancelled_ && active_task_count_ ) {
             std::unique_lock<std::mutex> lock(tasks_mutex_);
-            cond_var_.wait(lock, [this](){
+            ++active_waiter_count_;
+            waiter_cond_var_.wait(lock, [this](){
                 return cancelled_ || !active_task_count_ || !tasks_.empty();
             });
-            if ( !tasks_.empty() ) {
-                process_task_(std::move(lock));
+            --active_waiter_count_;
+            if ( !tasks_.empty() && process_task_(std::move(lock)) ) {
                 ++processed_tasks;
             }
         }
@@ -247,10 +677,36 @@ namespace jobber_hpp
             return std::make_pair(jobber_wait_status::cancelled, 0u);
         }
         if ( tasks_.empty() ) {
+            lock.unlock();
+            if ( task_ptr task = steal_task_(deques_.size()) ) {
+                task->run();
+                finish_task_();
+                return std::make_pair(jobber_wait_status::no_timeout, 1u);
+            }
             return std::make_pair(jobber_wait_status::no_timeout, 0u);
         }
-        process_task_(std::move(lock));
-        return std::make_pair(jobber_wait_status::no_timeout, 1u);
+        const bool processed = process_task_(std::move(lock));
+        return std::make_pair(jobber_wait_status::no_timeout, processed ? 1u : 0u);
+    }
+
+    template < typename Pred >
+    jobber::active_wait_result_t jobber::active_wait_one_unless(Pred&& pred) {
+        {
+            std::unique_lock<std::mutex> lock(tasks_mutex_);
+            ++active_waiter_count_;
+            waiter_cond_var_.wait(lock, [this, &pred](){
+                return cancelled_ || has_stealing_work_() || std::invoke(pred);
+            });
+            --active_waiter_count_;
+        }
+        return active_wait_one();
+    }
+
+    template < typename F >
+    void jobber::notify_waiters(F&& f) {
+        std::lock_guard<std::mutex> guard(tasks_mutex_);
+        std::invoke(std::forward<F>(f));
+        waiter_cond_var_.notify_all();
     }
 
     template < typename Rep, typename Period >
@@ -266,7 +722,7 @@ namespace jobber_hpp
         const std::chrono::time_point<Clock, Duration>& timeout_time) const
     {
         std::unique_lock<std::mutex> lock(tasks_mutex_);
-        return cond_var_.wait_until(lock, timeout_time, [this](){
+        return waiter_cond_var_.wait_until(lock, timeout_time, [this](){
             return cancelled_ || !active_task_count_;
         })  ? jobber_wait_status::no_timeout
             : jobber_wait_status::timeout;
@@ -292,11 +748,12 @@ namespace jobber_hpp
                     processed_tasks);
             }
             std::unique_lock<std::mutex> lock(tasks_mutex_);
-            cond_var_.wait_until(lock, timeout_time, [this](){
+            ++active_waiter_count_;
+            waiter_cond_var_.wait_until(lock, timeout_time, [this](){
                 return cancelled_ || !active_task_count_ || !tasks_.empty();
             });
-            if ( !tasks_.empty() ) {
-                process_task_(std::move(lock));
+            --active_waiter_count_;
+            if ( !tasks_.empty() && process_task_(std::move(lock)) ) {
                 ++processed_tasks;
             }
         }
@@ -307,19 +764,97 @@ namespace jobber_hpp
             processed_tasks);
     }
 
-    inline void jobber::push_task_(jobber_priority priority, task_ptr task) {
-        tasks_.emplace_back(priority, std::move(task));
-        std::push_heap(tasks_.begin(), tasks_.end());
+    inline void jobber::enqueue_task_(jobber_priority priority, task_ptr task) {
+        if ( priority == jobber_priority::normal ) {
+            const worker_context& worker = current_worker_();
+            if ( worker.owner == this ) {
+                push_local_task_(worker.index, std::move(task));
+                return;
+            }
+        }
+        std::vector<std::thread> retired_threads;
+        {
+            std::lock_guard<std::mutex> guard(tasks_mutex_);
+            push_task_(priority, std::move(task), retired_threads);
+        }
+        join_threads_(retired_threads);
+    }
+
+    inline void jobber::enqueue_tasks_(jobber_priority priority, std::vector<task_ptr> tasks) {
+        if ( tasks.empty() ) {
+            return;
+        }
+        if ( priority == jobber_priority::normal ) {
+            const worker_context& worker = current_worker_();
+            if ( worker.owner == this ) {
+                for ( task_ptr& task : tasks ) {
+                    ++active_task_count_;
+                    try {
+                        deques_[worker.index]->push(task.get());
+                        task.release();
+                    } catch (...) {
+                        finish_task_();
+                        wake_sleeping_workers_(tasks.size());
+                        throw;
+                    }
+                }
+                wake_sleeping_workers_(tasks.size());
+                return;
+            }
+        }
+        std::vector<std::thread> retired_threads;
+        {
+            std::lock_guard<std::mutex> guard(tasks_mutex_);
+            note_backlog_locked_();
+            try {
+                for ( task_ptr& task : tasks ) {
+                    tasks_.push(priority, std::move(task));
+                    ++active_task_count_;
+                    ++global_task_count_;
+                }
+            } catch (...) {
+                worker_cond_var_.notify_all();
+                waiter_cond_var_.notify_all();
+                throw;
+            }
+            for ( std::size_t i = 0; i < tasks.size() && sleeping_worker_count_ > pending_wakeups_; ++i ) {
+                wake_worker_locked_();
+            }
+            if ( active_waiter_count_ ) {
+                waiter_cond_var_.notify_all();
+            }
+            grow_if_backlogged_locked_(retired_threads);
+        }
+        join_threads_(retired_threads);
+    }
+
+    inline void jobber::push_task_(
+        jobber_priority priority,
+        task_ptr task,
+        std::vector<std::thread>& retired_threads)
+    {
+        note_backlog_locked_();
+        tasks_.push(priority, std::move(task));
         ++active_task_count_;
-        cond_var_.notify_one();
+        ++global_task_count_;
+        if ( !pending_wakeups_ ) {
+            wake_worker_locked_();
+        }
+        if ( active_waiter_count_ ) {
+            waiter_cond_var_.notify_all();
+        }
+        grow_if_backlogged_locked_(retired_threads);
     }
 
     inline jobber::task_ptr jobber::pop_task_() noexcept {
-        if ( !tasks_.empty() ) {
-            std::pop_heap(tasks_.begin(), tasks_.end());
-            task_ptr task = std::move(tasks_.back().second);
-            tasks_.pop_back();
-            return task;
+        while ( task_ptr task = tasks_.pop() ) {
+            --global_task_count_;
+            if ( !task->is_cancelled() ) {
+                return task;
+            }
+            if ( !--active_task_count_ ) {
+                waiter_cond_var_.notify_all();
+            }
         }
         return nullptr;
     }
@@ -335,43 +870,477 @@ namespace jobber_hpp
                 }
             }
             cancelled_.store(true);
-            cond_var_.notify_all();
+            worker_cond_var_.notify_all();
+            waiter_cond_var_.notify_all();
+            for ( std::thread& thread : threads_ ) {
+                if ( thread.joinable() ) {
+                    retired_threads_.push_back(std::move(thread));
+                }
+            }
+            threads_.clear();
         }
-        for ( std::thread& thread : threads_ ) {
-            if ( thread.joinable() ) {
-                thread.join();
+        join_threads_(retired_threads_);
+        for ( std::size_t i = 0; i < deques_.size(); ++i ) {
+            while ( task_ptr task = pop_local_task_(i) ) {
+                task->cancel();
+                --active_task_count_;
+            }
+        }
+        if ( !deques_.empty() ) {
+            std::lock_guard<std::mutex> guard(tasks_mutex_);
+            while ( task_ptr task = pop_task_() ) {
+                task->cancel();
+                --active_task_count_;
             }
         }
     }
 
-    inline void jobber::worker_main_() noexcept {
+    inline void jobber::worker_main_(std::size_t slot) noexcept {
         while ( true ) {
+            idle_spin_();
             std::unique_lock<std::mutex> lock(tasks_mutex_);
-            cond_var_.wait(lock, [this](){
+            if ( retire_request_count_ && !cancelled_ ) {
+                retire_worker_locked_(slot);
+                break;
+            }
+            const bool working = park_worker_(lock, [this](){
                 return cancelled_ || (!paused_ && !tasks_.empty());
             });
             if ( cancelled_ ) {
                 break;
             }
+            if ( !working ) {
+                retire_worker_locked_(slot);
+                break;
+            }
             process_task_(std::move(lock));
         }
     }
 
-    inline void jobber::process_task_(std::unique_lock<std::mutex> lock) noexcept {
+    inline bool jobber::process_task_(std::unique_lock<std::mutex> lock) noexcept {
         assert(lock.owns_lock());
         task_ptr task = pop_task_();
         if ( task ) {
+            if ( !tasks_.empty() && !pending_wakeups_ ) {
+                wake_worker_locked_();
+            }
             lock.unlock();
             task->run();
+            task.reset();
             lock.lock();
-            --active_task_count_;
-            cond_var_.notify_all();
+            if ( !--active_task_count_ ) {
+                waiter_cond_var_.notify_all();
+            }
+            return true;
+        }
+        return false;
+    }
+
+    inline void jobber::spawn_worker_locked_(std::vector<std::thread>& retired_threads) {
+        take_retired_threads_locked_(retired_threads);
+        std::size_t slot = 0u;
+        while ( slot < threads_.size() && threads_[slot].joinable() ) {
+            ++slot;
+        }
+        if ( slot == threads_.size() ) {
+            threads_.emplace_back();
+        }
+        // a retiring worker moves its thread here under the lock
+        retired_threads_.reserve(threads_.size());
+        threads_[slot] = work_stealing_
+            ? std::thread(&jobber::stealing_worker_main_, this, slot)
+            : std::thread(&jobber::worker_main_, this, slot);
+        ++live_thread_count_;
+        if ( !cpu_sets_.empty() ) {
+            impl::pin_thread(threads_[slot], cpu_sets_[slot % cpu_sets_.size()]);
+        }
+    }
+
+    inline void jobber::retire_worker_locked_(std::size_t slot) noexcept {
+        if ( retire_request_count_ ) {
+            --retire_request_count_;
+        }
+        --live_thread_count_;
+        retired_threads_.push_back(std::move(threads_[slot]));
+    }
+
+    // retired workers do not touch the jobber after releasing the lock,
+    // the caller joins them once it has released the lock too
+
+    inline void jobber::take_retired_threads_locked_(std::vector<std::thread>& retired_threads) {
+        if ( !retired_threads_.empty() ) {
+            retired_threads.reserve(retired_threads.size() + retired_threads_.size());
+            for ( std::thread& thread : retired_threads_ ) {
+                retired_threads.push_back(std::move(thread));
+            }
+            retired_threads_.clear();
         }
     }
+
+    inline void jobber::join_threads_(std::vector<std::thread>& threads) noexcept {
+        for ( std::thread& thread : threads ) {
+            thread.join();
+        }
+        threads.clear();
+    }
+
+    inline void jobber::note_backlog_locked_() noexcept {
+        if ( tasks_.empty() && live_thread_count_ < max_threads_ ) {
+            backlog_since_ = std::chrono::steady_clock::now();
+        }
+    }
+
+    inline void jobber::grow_if_backlogged_locked_(std::vector<std::thread>& retired_threads) noexcept {
+        if ( cancelled_ || sleeping_worker_count_ || live_thread_count_ >= max_threads_ ) {
+            return;
+        }
+        const auto now = std::chrono::steady_clock::now();
+        if ( now - backlog_since_ < elasticity_.max_queue_delay ) {
+            return;
+        }
+        try {
+            spawn_worker_locked_(retired_threads);
+        } catch (...) {
+            // the task is queued anyway, the existing workers will run it
+        }
+        backlog_since_ = now;
+    }
+
+    inline jobber::worker_context& jobber::current_worker_() noexcept {
+        static thread_local worker_context worker;
+        return worker;
+    }
+
+    inline void jobber::push_local_task_(std::size_t index, task_ptr task) {
+        ++active_task_count_;
+        try {
+            deques_[index]->push(task.get());
+            task.release();
+        } catch (...) {
+            finish_task_();
+            throw;
+        }
+        wake_sleeping_workers_(1u);
+    }
+
+    inline void jobber::wake_sleeping_workers_(std::size_t count) noexcept {
+        if ( sleeping_worker_count_ ) {
+            std::lock_guard<std::mutex> guard(tasks_mutex_);
+            if ( count < sleeping_worker_count_ ) {
+                for ( std::size_t i = 0; i < count; ++i ) {
+                    worker_cond_var_.notify_one();
+                }
+            } else {
+                worker_cond_var_.notify_all();
+            }
+        }
+    }
+
+    // at most one wakeup is in flight for a single push, a woken worker
+    // that still sees queued tasks passes the wakeup on to the next one,
+    // every return from the wait consumes one wakeup even if the worker
+    // goes back to sleep, otherwise a stale one would block the next push
+
+    inline void jobber::wake_worker_locked_() noexcept {
+        if ( sleeping_worker_count_ > pending_wakeups_ ) {
+            ++pending_wakeups_;
+            worker_cond_var_.notify_one();
+        }
+    }
+
+    // returns false when the worker has to retire, either because of
+    // 'resize' or because it has been idle for 'idle_timeout'
+
+    template < typename Pred >
+    bool jobber::park_worker_(std::unique_lock<std::mutex>& lock, Pred&& pred) noexcept {
+        bool working = true;
+        bool has_deadline = false;
+        std::chrono::steady_clock::time_point deadline;
+        ++sleeping_worker_count_;
+        while ( !pred() ) {
+            if ( live_thread_count_ <= min_threads_ ) {
+                worker_cond_var_.wait(lock);
+            } else if ( retire_request_count_ ) {
+                working = false;
+                break;
+            } else {
+                if ( !has_deadline ) {
+                    has_deadline = true;
+                    deadline = std::chrono::steady_clock::now() + elasticity_.idle_timeout;
+                }
+                if ( worker_cond_var_.wait_until(lock, deadline) == std::cv_status::timeout
+                    && !pred() && live_thread_count_ > min_threads_ )
+                {
+                    working = false;
+                }
+            }
+            if ( pending_wakeups_ ) {
+                --pending_wakeups_;
+            }
+            if ( !working ) {
+                break;
+            }
+        }
+        --sleeping_worker_count_;
+        pending_wakeups_ = std::min(pending_wakeups_, sleeping_worker_count_.load());
+        return working;
+    }
+
+    inline void jobber::cpu_relax_() noexcept {
+    #if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+        _mm_pause();
+    #elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+        __builtin_ia32_pause();
+    #elif (defined(__GNUC__) || defined(__clang__)) && defined(__aarch64__)
+        __asm__ __volatile__("yield");
+    #endif
+    }
+
+    // lock-free check, queued tasks are counted by 'global_task_count_'
+    // and local deques can be inspected without the mutex
+
+    inline bool jobber::has_pending_work_() const noexcept {
+        if ( cancelled_ ) {
+            return true;
+        }
+        if ( paused_ ) {
+            return false;
+        }
+        if ( global_task_count_ ) {
+            return true;
+        }
+        return std::any_of(deques_.begin(), deques_.end(), [](const task_deque_ptr& d){
+            return !d->empty();
+        });
+    }
+
+    inline void jobber::idle_spin_() const noexcept {
+        for ( std::size_t i = 0; i < idle_strategy_.spin_count; ++i ) {
+            if ( has_pending_work_() ) {
+                return;
+            }
+            cpu_relax_();
+        }
+        for ( std::size_t i = 0; i < idle_strategy_.yield_count; ++i ) {
+            if ( has_pending_work_() ) {
+                return;
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    inline jobber::task_ptr jobber::pop_local_task_(std::size_t index) noexcept {
+        while ( task* t = deques_[index]->pop() ) {
+            task_ptr task(t);
+            if ( !task->is_cancelled() ) {
+                return task;
+            }
+            finish_task_();
+        }
+        return nullptr;
+    }
+
+    inline jobber::task_ptr jobber::pop_global_task_() noexcept {
+        if ( !global_task_count_ ) {
+            return nullptr;
+        }
+        std::lock_guard<std::mutex> guard(tasks_mutex_);
+        task_ptr task = pop_task_();
+        if ( task && !tasks_.empty() && !pending_wakeups_ ) {
+            wake_worker_locked_();
+        }
+        return task;
+    }
+
+    inline jobber::task_ptr jobber::steal_task_(std::size_t thief) noexcept {
+        if ( deques_.empty() ) {
+            return nullptr;
+        }
+        static thread_local std::minstd_rand rng{
+            static_cast<std::minstd_rand::result_type>(
+                std::hash<std::thread::id>()(std::this_thread::get_id()))};
+        const std::size_t first = rng() % deques_.size();
+        // the first pass visits only the workers of the thief's group,
+        // non-worker thieves have no group and skip it
+        const bool grouped = thief < worker_groups_.size();
+        for ( std::size_t pass = grouped ? 0u : 1u; pass < 2u; ++pass ) {
+            for ( std::size_t i = 0; i < deques_.size(); ++i ) {
+                const std::size_t victim = (first + i) % deques_.size();
+                if ( victim == thief ) {
+                    continue;
+                }
+                if ( grouped && (worker_groups_[victim] == worker_groups_[thief]) != (pass == 0u) ) {
+                    continue;
+                }
+                while ( task* t = deques_[victim]->steal() ) {
+                    task_ptr task(t);
+                    if ( !task->is_cancelled() ) {
+                        return task;
+                    }
+                    finish_task_();
+                }
+            }
+        }
+        return nullptr;
+    }
+
+    inline bool jobber::has_stealing_work_() const noexcept {
+        if ( !tasks_.empty() ) {
+            return true;
+        }
+        return std::any_of(deques_.begin(), deques_.end(), [](const task_deque_ptr& d){
+            return !d->empty();
+        });
+    }
+
+    inline void jobber::finish_task_() noexcept {
+        if ( !--active_task_count_ ) {
+            std::lock_guard<std::mutex> guard(tasks_mutex_);
+            waiter_cond_var_.notify_all();
+        }
+    }
+
+    inline void jobber::stealing_worker_main_(std::size_t index) noexcept {
+        current_worker_() = worker_context{this, index};
+        // checks the shared queue now and then even with a busy local
+        // deque, so self-spawning tasks cannot starve external ones
+        const std::size_t global_check_interval = 61u;
+        std::size_t local_tick = 0u;
+        while ( !cancelled_ ) {
+            task_ptr task;
+            if ( !paused_ ) {
+                if ( ++local_tick % global_check_interval == 0u ) {
+                    task = pop_global_task_();
+                }
+                if ( !task ) {
+                    task = pop_local_task_(index);
+                }
+                if ( !task ) {
+                    task = pop_global_task_();
+                }
+                if ( !task ) {
+                    task = steal_task_(index);
+                }
+            }
+            if ( task ) {
+                task->run();
+                task.reset();
+                finish_task_();
+                // the request is read without the lock first to keep
+                // the lock off the path of every task
+                if ( retire_request_count_.load(std::memory_order_relaxed)
+                    && deques_[index]->empty() )
+                {
+                    std::lock_guard<std::mutex> guard(tasks_mutex_);
+                    if ( retire_request_count_ && !cancelled_ ) {
+                        retire_worker_locked_(index);
+                        break;
+                    }
+                }
+                continue;
+            }
+            idle_spin_();
+            if ( has_pending_work_() ) {
+                continue;
+            }
+            // the local deque is empty here and only the owner
+            // pushes to it, so nothing is left behind on retirement
+            std::unique_lock<std::mutex> lock(tasks_mutex_);
+            const bool working = park_worker_(lock, [this](){
+                return cancelled_ || (!paused_ && has_stealing_work_());
+            });
+            if ( !working && !cancelled_ ) {
+                retire_worker_locked_(index);
+                break;
+            }
+        }
+        current_worker_() = worker_context();
+    }
 }
 
 namespace jobber_hpp
 {
+    //
+    // task_deque
+    //
+
+    inline jobber::task_deque::task_deque(std::size_t capacity) {
+        std::size_t pow2 = 1u;
+        while ( pow2 < capacity ) {
+            pow2 <<= 1u;
+        }
+        buffers_.push_back(std::make_unique<buffer>(pow2));
+        buffer_.store(buffers_.back().get());
+    }
+
+    inline jobber::task_deque::~task_deque() noexcept {
+        while ( task* t = pop() ) {
+            delete t;
+        }
+    }
+
+    inline void jobber::task_deque::push(task* t) {
+        const std::int64_t b = bottom_.load(std::memory_order_relaxed);
+        const std::int64_t tp = top_.load(std::memory_order_acquire);
+        buffer* a = buffer_.load(std::memory_order_relaxed);
+        if ( b - tp > a->capacity() - 1 ) {
+            a = grow_(a, b, tp);
+        }
+        a->put(b, t);
+        bottom_.store(b + 1);
+    }
+
+    inline jobber::task* jobber::task_deque::pop() noexcept {
+        const std::int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+        buffer* a = buffer_.load(std::memory_order_relaxed);
+        bottom_.store(b);
+        std::int64_t tp = top_.load();
+        if ( tp > b ) {
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        task* t = a->get(b);
+        if ( tp == b ) {
+            if ( !top_.compare_exchange_strong(tp, tp + 1) ) {
+                t = nullptr;
+            }
+            bottom_.store(b + 1, std::memory_order_relaxed);
+        }
+        return t;
+    }
+
+    inline jobber::task* jobber::task_deque::steal() noexcept {
+        while ( true ) {
+            std::int64_t tp = top_.load();
+            const std::int64_t b = bottom_.load();
+            if ( tp >= b ) {
+                return nullptr;
+            }
+            buffer* a = buffer_.load(std::memory_order_acquire);
+            task* t = a->get(tp);
+            if ( top_.compare_exchange_strong(tp, tp + 1) ) {
+                return t;
+            }
+        }
+    }
+
+    inline bool jobber::task_deque::empty() const noexcept {
+        return top_.load() >= bottom_.load();
+    }
+
+    inline jobber::task_deque::buffer* jobber::task_deque::grow_(
+        buffer* old, std::int64_t bottom, std::int64_t top)
+    {
+        buffers_.reserve(buffers_.size() + 1u);
+        auto a = std::make_unique<buffer>(static_cast<std::size_t>(old->capacity()) * 2u);
+        for ( std::int64_t i = top; i < bottom; ++i ) {
+            a->put(i, old->get(i));
+        }
+        buffers_.push_back(std::move(a));
+        buffer_.store(buffers_.back().get(), std::memory_order_release);
+        return buffers_.back().get();
+    }
+
     //
     // concrete_task<R, F, Args...>
     //
@@ -397,6 +1366,11 @@ namespace jobber_hpp
         promise_.reject(jobber_cancelled_exception());
     }
 
+    template < typename R, typename F, typename... Args >
+    bool jobber::concrete_task<R, F, Args...>::is_cancelled() const noexcept {
+        return promise_.is_cancelled();
+    }
+
     template < typename R, typename F, typename... Args >
     promise<R> jobber::concrete_task<R, F, Args...>::future() noexcept {
         return promise_;
@@ -427,6 +1401,11 @@ namespace jobber_hpp
         promise_.reject(jobber_cancelled_exception());
     }
 
+    template < typename F, typename... Args >
+    bool jobber::concrete_task<void, F, Args...>::is_cancelled() const noexcept {
+        return promise_.is_cancelled();
+    }
+
     template < typename F, typename... Args >
     promise<void> jobber::concrete_task<void, F, Args...>::future() noexcept {
         return promise_;
@@ -0,0 +1,311 @@
+/*******************************************************************************
+ * This file is part of the "https://github.com/blackmatov/promise.hpp"
+ * For conditions of distribution and use, see copyright notice in LICENSE.md
+ * Copyright (C) 2018-2023, by Matvey Cherevko (blackmatov@gmail.com)
+ ******************************************************************************/
+
+#pragma once
+
+#include "jobber.hpp"
+
+#include <numeric>
+#include <algorithm>
+
+// ranges are split into chunks that are submitted with 'async_bulk', the
+// caller must keep the ranges and the jobber alive until the returned
+// promise is settled, 'active_get' lets the calling thread help
+
+namespace parallel_hpp
+{
+    using namespace jobber_hpp;
+
+    namespace impl
+    {
+        // about four chunks per worker, so that uneven chunks
+        // are balanced by the workers that finish first
+
+        inline std::size_t grain_size_for(
+            std::size_t size,
+            std::size_t threads,
+            std::size_t grain_size) noexcept
+        {
+            if ( grain_size ) {
+                return grain_size;
+            }
+            const std::size_t chunks = std::max(threads, std::size_t{1u}) * 4u;
+            return std::max((size + chunks - 1u) / chunks, std::size_t{1u});
+        }
+
+        template < typename Iter >
+        struct chunk_t {
+            Iter first;
+            Iter last;
+            std::size_t offset;
+        };
+
+        template < typename Iter >
+        std::vector<chunk_t<Iter>> make_chunks(
+            Iter begin,
+            Iter end,
+            std::size_t threads,
+            std::size_t grain_size)
+        {
+            const std::size_t size = static_cast<std::size_t>(std::distance(begin, end));
+            const std::size_t grain = grain_size_for(size, threads, grain_size);
+            std::vector<chunk_t<Iter>> chunks;
+            chunks.reserve((size + grain - 1u) / grain);
+            for ( std::size_t offset = 0; offset < size; offset += grain ) {
+                const std::size_t count = std::min(grain, size - offset);
+                Iter last = std::next(begin, static_cast<std::ptrdiff_t>(count));
+                chunks.push_back(chunk_t<Iter>{begin, last, offset});
+                begin = last;
+            }
+            return chunks;
+        }
+
+        template < typename Iter, typename Compare >
+        promise<void> merge_sorted_chunks(
+            jobber& executor,
+            std::vector<Iter> bounds,
+            Compare comp)
+        {
+            if ( bounds.size() <= 2u ) {
+                return make_resolved_promise();
+            }
+            std::vector<std::array<Iter, 3>> merges;
+            std::vector<Iter> next_bounds;
+            for ( std::size_t i = 0; i + 2u < bounds.size(); i += 2u ) {
+                merges.push_back({bounds[i], bounds[i + 1u], bounds[i + 2u]});
+                next_bounds.push_back(bounds[i]);
+            }
+            if ( bounds.size() % 2u == 0u ) {
+                next_bounds.push_back(bounds[bounds.size() - 2u]);
+            }
+            next_bounds.push_back(bounds.back());
+            std::vector<promise<void>> merged = executor.async_bulk(
+                merges.begin(),
+                merges.end(),
+                [comp](const std::array<Iter, 3>& m){
+                    std::inplace_merge(m[0], m[1], m[2], comp);
+                });
+            return make_all_promise(merged)
+            .then([&executor, next_bounds = std::move(next_bounds), comp](){
+                return merge_sorted_chunks(executor, next_bounds, comp);
+            });
+        }
+    }
+
+    //
+    // active_get
+    //
+
+    // waits for the promise while processing tasks of the jobber, the
+    // settled flag is set under the jobber lock, which the jobber takes
+    // again before destruction, so the handler never outlives it
+
+    template < typename T >
+    decltype(auto) active_get(jobber& executor, const promise<T>& p) {
+        auto settled = std::make_shared<std::atomic<bool>>(false);
+        const auto on_settle = [&executor, settled](auto&&...){
+            executor.notify_waiters([&settled](){
+                settled->store(true);
+            });
+        };
+        promise_subscription subscription = promise<T>(p).subscribe(on_settle, on_settle);
+        while ( !settled->load() ) {
+            const auto r = executor.active_wait_one_unless([&settled](){
+                return settled->load();
+            });
+            if ( r.first == jobber_wait_status::cancelled ) {
+                subscription.unsubscribe();
+                break;
+            }
+        }
+        return p.get();
+    }
+
+    //
+    // parallel_for
+    //
+
+    // 'f' is shared between the chunks and may be called concurrently,
+    // it does not have to be const-invocable but has to guard its state
+
+    template < typename Iter, typename F >
+    promise<void> parallel_for(
+        jobber& executor,
+        Iter begin,
+        Iter end,
+        F&& f,
+        std::size_t grain_size = 0u)
+    {
+        using chunk_t = impl::chunk_t<Iter>;
+        std::vector<chunk_t> chunks = impl::make_chunks(
+            begin, end, executor.thread_count(), grain_size);
+        std::vector<promise<void>> done = executor.async_bulk(
+            chunks.begin(),
+            chunks.end(),
+            [f = std::forward<F>(f)](const chunk_t& c) mutable {
+                for ( Iter iter = c.first; iter != c.last; ++iter ) {
+                    std::invoke(f, *iter);
+                }
+            });
+        return make_all_promise(done);
+    }
+
+    //
+    // parallel_transform
+    //
+
+    // 'f' is shared between the chunks like in 'parallel_for'
+
+    template < typename Iter, typename OutIter, typename F >
+    promise<void> parallel_transform(
+        jobber& executor,
+        Iter begin,
+        Iter end,
+        OutIter d_first,
+        F&& f,
+        std::size_t grain_size = 0u)
+    {
+        using chunk_t = impl::chunk_t<Iter>;
+        std::vector<chunk_t> chunks = impl::make_chunks(
+            begin, end, executor.thread_count(), grain_size);
+        std::vector<promise<void>> done = executor.async_bulk(
+            chunks.begin(),
+            chunks.end(),
+            [d_first, f = std::forward<F>(f)](const chunk_t& c) mutable {
+                std::transform(
+                    c.first,
+                    c.last,
+                    std::next(d_first, static_cast<std::ptrdiff_t>(c.offset)),
+                    f);
+            });
+        return make_all_promise(done);
+    }
+
+    //
+    // parallel_reduce
+    //
+
+    // 'op' must be associative and commutative, chunks are folded with
+    // std::reduce, which is free to reorder and vectorize contiguous
+    // arithmetic ranges
+
+    template < typename Iter, typename T, typename BinaryOp = std::plus<> >
+    promise<T> parallel_reduce(
+        jobber& executor,
+        Iter begin,
+        Iter end,
+        T init,
+        BinaryOp op = BinaryOp(),
+        std::size_t grain_size = 0u)
+    {
+        using chunk_t = impl::chunk_t<Iter>;
+        std::vector<chunk_t> chunks = impl::make_chunks(
+            begin, end, executor.thread_count(), grain_size);
+        std::vector<promise<T>> partials = executor.async_bulk(
+            chunks.begin(),
+            chunks.end(),
+            [op](const chunk_t& c) -> T {
+                return std::reduce(std::next(c.first), c.last, T(*c.first), op);
+            });
+        return make_all_promise(partials)
+        .then([init = std::move(init), op](const std::vector<T>& values){
+            return std::accumulate(values.begin(), values.end(), init, op);
+        });
+    }
+
+    //
+    // parallel_inclusive_scan
+    //
+
+    // the first pass reduces every chunk, the second one scans
+    // the chunks again starting from the prefix of the previous ones
+
+    template < typename Iter, typename OutIter, typename BinaryOp = std::plus<> >
+    promise<void> parallel_inclusive_scan(
+        jobber& executor,
+        Iter begin,
+        Iter end,
+        OutIter d_first,
+        BinaryOp op = BinaryOp(),
+        std::size_t grain_size = 0u)
+    {
+        using chunk_t = impl::chunk_t<Iter>;
+        using value_t = typename std::iterator_traits<Iter>::value_type;
+        std::vector<chunk_t> chunks = impl::make_chunks(
+            begin, end, executor.thread_count(), grain_size);
+        if ( chunks.empty() ) {
+            return make_resolved_promise();
+        }
+        std::vector<chunk_t> tail_chunks(chunks.begin(), chunks.end() - 1);
+        std::vector<promise<value_t>> partials = executor.async_bulk(
+            tail_chunks.begin(),
+            tail_chunks.end(),
+            [op](const chunk_t& c) -> value_t {
+                return std::reduce(std::next(c.first), c.last, value_t(*c.first), op);
+            });
+        return make_all_promise(partials)
+        .then([&executor, chunks = std::move(chunks), d_first, op](const std::vector<value_t>& sums){
+            std::vector<std::pair<chunk_t, value_t>> scans;
+            scans.reserve(sums.size());
+            for ( std::size_t i = 0; i < sums.size(); ++i ) {
+                scans.emplace_back(chunks[i + 1u], i ? op(scans.back().second, sums[i]) : sums[i]);
+            }
+            const chunk_t& head = chunks.front();
+            std::inclusive_scan(
+                head.first,
+                head.last,
+                std::next(d_first, static_cast<std::ptrdiff_t>(head.offset)),
+                op);
+            std::vector<promise<void>> done = executor.async_bulk(
+                scans.begin(),
+                scans.end(),
+                [d_first, op](const std::pair<chunk_t, value_t>& s){
+                    std::inclusive_scan(
+                        s.first.first,
+                        s.first.last,
+                        std::next(d_first, static_cast<std::ptrdiff_t>(s.first.offset)),
+                        op,
+                        s.second);
+                });
+            return make_all_promise(done);
+        });
+    }
+
+    //
+    // parallel_sort
+    //
+
+    // sorts chunks in parallel and merges them pairwise in parallel rounds
+
+    template < typename Iter, typename Compare = std::less<> >
+    promise<void> parallel_sort(
+        jobber& executor,
+        Iter begin,
+        Iter end,
+        Compare comp = Compare(),
+        std::size_t grain_size = 0u)
+    {
+        using chunk_t = impl::chunk_t<Iter>;
+        std::vector<chunk_t> chunks = impl::make_chunks(
+            begin, end, executor.thread_count(), grain_size);
+        std::vector<Iter> bounds;
+        bounds.reserve(chunks.size() + 1u);
+        for ( const chunk_t& c : chunks ) {
+            bounds.push_back(c.first);
+        }
+        bounds.push_back(end);
+        std::vector<promise<void>> sorted = executor.async_bulk(
+            chunks.begin(),
+            chunks.end(),
+            [comp](const chunk_t& c){
+                std::sort(c.first, c.last, comp);
+            });
+        return make_all_promise(sorted)
+        .then([&executor, bounds = std::move(bounds), comp](){
+            return impl::merge_sorted_chunks(executor, bounds, comp);
+        });
+    }
+}
@@ -34,9 +34,16 @@ namespace scheduler_hpp
         : std::runtime_error("scheduler has stopped working") {}
     };
 
+    // receives exceptions escaping posted tasks, invoked on the thread
+    // that processes the task and must not throw, without a handler
+    // such exceptions are dropped
+
+    using scheduler_error_handler = std::function<void(std::exception_ptr)>;
+
     class scheduler final : private detail::noncopyable {
     public:
         scheduler();
+        explicit scheduler(scheduler_error_handler error_handler);
         ~scheduler() noexcept;
 
         using processing_result_t = std::pair<
@@ -56,6 +63,14 @@ namespace scheduler_hpp
                  , typename R = schedule_invoke_result_t<F, Args...> >
         promise<R> schedule(scheduler_priority scheduler_priority, F&& f, Args&&... args);
 
+        template < typename F, typename... Args
+                 , typename R = schedule_invoke_result_t<F, Args...> >
+        void post(F&& f, Args&&... args);
+
+        template < typename F, typename... Args
+                 , typename R = schedule_invoke_result_t<F, Args...> >
+        void post(scheduler_priority scheduler_priority, F&& f, Args&&... args);
+
         processing_result_t process_one_task() noexcept;
         processing_result_t process_all_tasks() noexcept;
 
@@ -67,30 +82,27 @@ namespace scheduler_hpp
         processing_result_t process_tasks_until(
             const std::chrono::time_point<Clock, Duration>& timeout_time) noexcept;
     private:
-        class task;
+        using task = detail::pooled_task;
         using task_ptr = std::unique_ptr<task>;
         template < typename R, typename F, typename... Args >
         class concrete_task;
+        template < typename F, typename... Args >
+        using posted_task = detail::posted_task<F, Args...>;
+        using task_queue = detail::priority_task_queue<scheduler_priority, task_ptr>;
     private:
         void push_task_(scheduler_priority scheduler_priority, task_ptr task);
         task_ptr pop_task_() noexcept;
         void shutdown_() noexcept;
-        void process_task_(std::unique_lock<std::mutex> lock) noexcept;
+        bool process_task_(std::unique_lock<std::mutex> lock) noexcept;
     private:
-        std::vector<std::pair<scheduler_priority, task_ptr>> tasks_;
+        task_queue tasks_;
         std::atomic<bool> cancelled_{false};
         std::atomic<std::size_t> active_task_count_{0};
+        const scheduler_error_handler error_handler_;
         mutable std::mutex tasks_mutex_;
         mutable std::condition_variable cond_var_;
     };
 
-    class scheduler::task : private detail::noncopyable {
-    public:
-        virtual ~task() noexcept = default;
-        virtual void run() noexcept = 0;
-        virtual void cancel() noexcept = 0;
-    };
-
     template < typename R, typename F, typename... Args >
     class scheduler::concrete_task final : public task {
         F f_;
@@ -101,6 +113,7 @@ namespace scheduler_hpp
         concrete_task(U&& u, std::tuple<Args...>&& args);
         void run() noexcept final;
         void cancel() noexcept final;
+        bool is_cancelled() const noexcept final;
         promise<R> future() noexcept;
     };
 
@@ -114,6 +127,7 @@ namespace scheduler_hpp
         concrete_task(U&& u, std::tuple<Args...>&& args);
         void run() noexcept final;
         void cancel() noexcept final;
+        bool is_cancelled() const noexcept final;
         promise<void> future() noexcept;
     };
 }
@@ -122,6 +136,9 @@ namespace scheduler_hpp
 {
     inline scheduler::scheduler() = default;
 
+    inline scheduler::scheduler(scheduler_error_handler error_handler)
+    : error_handler_(std::move(error_handler)) {}
+
     inline scheduler::~scheduler() noexcept {
         shutdown_();
     }
@@ -149,6 +166,27 @@ namespace scheduler_hpp
         return future;
     }
 
+    template < typename F, typename... Args, typename R >
+    void scheduler::post(F&& f, Args&&... args) {
+        post(
+            scheduler_priority::normal,
+            std::forward<F>(f),
+            std::forward<Args>(args)...);
+    }
+
+    template < typename F, typename... Args, typename R >
+    void scheduler::post(scheduler_priority priority, F&& f, Args&&... args) {
+        using task_t = posted_task<
+            std::decay_t<F>,
+            std::decay_t<Args>...>;
+        task_ptr task = std::make_unique<task_t>(
+            &error_handler_,
+            std::forward<F>(f),
+            std::make_tuple(std::forward<Args>(args)...));
+        std::lock_guard<std::mutex> guard(tasks_mutex_);
+        push_task_(priority, std::move(task));
+    }
+
     inline scheduler::processing_result_t scheduler::process_one_task() noexcept {
         std::unique_lock<std::mutex> lock(tasks_mutex_);
         if ( cancelled_ ) {
@@ -157,8 +195,8 @@ namespace scheduler_hpp
         if ( tasks_.empty() ) {
             return std::make_pair(scheduler_processing_status::done, 0u);
         }
-        process_task_(std::move(lock));
-        return std::make_pair(scheduler_processing_status::done, 1u);
+        const bool processed = process_task_(std::move(lock));
+        return std::make_pair(scheduler_processing_status::done, processed ? 1u : 0u);
     }
 
     inline scheduler::processing_result_t scheduler::process_all_tasks() noexcept {
@@ -168,8 +206,7 @@ namespace scheduler_hpp
             cond_var_.wait(lock, [this](){
                 return cancelled_ || !active_task_count_ || !tasks_.empty();
             });
-            if ( !tasks_.empty() ) {
-                process_task_(std::move(lock));
+            if ( !tasks_.empty() && process_task_(std::move(lock)) ) {
                 ++processed_tasks;
             }
         }
@@ -203,8 +240,7 @@ namespace scheduler_hpp
             cond_var_.wait_until(lock, timeout_time, [this](){
                 return cancelled_ || !active_task_count_ || !tasks_.empty();
             });
-            if ( !tasks_.empty() ) {
-                process_task_(std::move(lock));
+            if ( !tasks_.empty() && process_task_(std::move(lock)) ) {
                 ++processed_tasks;
             }
         }
@@ -216,18 +252,19 @@ namespace scheduler_hpp
     }
 
     inline void scheduler::push_task_(scheduler_priority priority, task_ptr task) {
-        tasks_.emplace_back(priority, std::move(task));
-        std::push_heap(tasks_.begin(), tasks_.end());
+        tasks_.push(priority, std::move(task));
         ++active_task_count_;
         cond_var_.notify_one();
     }
 
     inline scheduler::task_ptr scheduler::pop_task_() noexcept {
-        if ( !tasks_.empty() ) {
-            std::pop_heap(tasks_.begin(), tasks_.end());
-            task_ptr task = std::move(tasks_.back().second);
-            tasks_.pop_back();
-            return task;
+        while ( task_ptr task = tasks_.pop() ) {
+            if ( !task->is_cancelled() ) {
+                return task;
+            }
+            if ( !--active_task_count_ ) {
+                cond_var_.notify_all();
+            }
         }
         return nullptr;
     }
@@ -245,7 +282,7 @@ namespace scheduler_hpp
         cond_var_.notify_all();
     }
 
-    inline void scheduler::process_task_(std::unique_lock<std::mutex> lock) noexcept {
+    inline bool scheduler::process_task_(std::unique_lock<std::mutex> lock) noexcept {
         assert(lock.owns_lock());
         task_ptr task = pop_task_();
         if ( task ) {
@@ -254,7 +291,9 @@ namespace scheduler_hpp
             lock.lock();
             --active_task_count_;
             cond_var_.notify_all();
+            return true;
         }
+        return false;
     }
 }
 
@@ -285,6 +324,11 @@ namespace scheduler_hpp
         promise_.reject(scheduler_cancelled_exception());
     }
 
+    template < typename R, typename F, typename... Args >
+    bool scheduler::concrete_task<R, F, Args...>::is_cancelled() const noexcept {
+        return promise_.is_cancelled();
+    }
+
     template < typename R, typename F, typename... Args >
     promise<R> scheduler::concrete_task<R, F, Args...>::future() noexcept {
         return promise_;
@@ -315,6 +359,11 @@ namespace scheduler_hpp
         promise_.reject(scheduler_cancelled_exception());
     }
 
+    template < typename F, typename... Args >
+    bool scheduler::concrete_task<void, F, Args...>::is_cancelled() const noexcept {
+        return promise_.is_cancelled();
+    }
+
     template < typename F, typename... Args >
     promise<void> scheduler::concrete_task<void, F, Args...>::future() noexcept {
         return promise_;
@@ -0,0 +1,833 @@
+/*******************************************************************************
+ * This file is part of the "https://github.com/blackmatov/promise.hpp"
+ * For conditions of distribution and use, see copyright notice in LICENSE.md
+ * Copyright (C) 2018-2023, by Matvey Cherevko (blackmatov@gmail.com)
+ ******************************************************************************/
+
+#pragma once
+
+#include "../promise.hpp"
+
+#include <limits>
+#include <random>
+#include <algorithm>
+
+namespace timer_hpp
+{
+    using namespace promise_hpp;
+
+    class timeout_exception final : public std::runtime_error {
+    public:
+        timeout_exception()
+        : std::runtime_error("promise has timed out") {}
+    };
+
+    class timer_wheel final : private detail::noncopyable {
+    public:
+        using clock_type = std::chrono::steady_clock;
+
+        class timer_id final {
+        public:
+            timer_id() = default;
+        private:
+            friend class timer_wheel;
+            timer_id(std::size_t index, std::uint64_t generation) noexcept
+            : index_(index)
+            , generation_(generation) {}
+        private:
+            std::size_t index_{0u};
+            std::uint64_t generation_{0u};
+        };
+    public:
+        explicit timer_wheel(clock_type::duration tick = std::chrono::milliseconds(1));
+        ~timer_wheel() noexcept;
+
+        static timer_wheel& shared();
+
+        // callbacks run one after another on the wheel thread, so they
+        // must be cheap and must not throw, anything heavier should be
+        // posted to an executor like 'jobber' from the callback
+
+        template < typename F >
+        timer_id schedule_at(clock_type::time_point time, F&& f);
+
+        template < typename Rep, typename Period, typename F >
+        timer_id schedule_after(const std::chrono::duration<Rep, Period>& duration, F&& f);
+
+        bool cancel(timer_id id) noexcept;
+
+        std::size_t timer_count() const noexcept;
+        clock_type::duration tick() const noexcept;
+    private:
+        using callback_t = std::function<void()>;
+
+        static constexpr std::size_t level_bits = 6u;
+        static constexpr std::size_t level_count = 4u;
+        static constexpr std::size_t slot_count = std::size_t{1u} << level_bits;
+        static constexpr std::size_t slot_mask = slot_count - 1u;
+        static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+        static constexpr std::uint64_t max_delta =
+            (std::uint64_t{1u} << (level_bits * level_count)) - 1u;
+
+        struct timer final {
+            callback_t callback;
+            std::uint64_t expiry{0u};
+            // starts at one, so a default 'timer_id' never matches a timer
+            std::uint64_t generation{1u};
+            std::size_t slot{npos};
+            std::size_t prev{npos};
+            std::size_t next{npos};
+        };
+    private:
+        std::uint64_t now_tick_() const noexcept;
+        std::uint64_t time_to_tick_(clock_type::time_point time) const noexcept;
+        std::size_t acquire_timer_();
+        void release_timer_(std::size_t index) noexcept;
+        void link_timer_(std::size_t index) noexcept;
+        void unlink_timer_(std::size_t index) noexcept;
+        void advance_tick_(std::vector<callback_t>& expired);
+        std::uint64_t next_event_tick_() const noexcept;
+        void worker_main_() noexcept;
+    private:
+        const clock_type::duration tick_;
+        const clock_type::time_point start_time_;
+        std::uint64_t current_tick_{0u};
+        std::uint64_t wake_tick_{0u};
+        std::size_t timer_count_{0u};
+        std::size_t free_timers_{npos};
+        std::vector<timer> timers_;
+        std::array<std::size_t, slot_count * level_count> slots_;
+        bool stopped_{false};
+        mutable std::mutex mutex_;
+        std::condition_variable cond_var_;
+        std::thread thread_;
+    };
+
+    template < typename T >
+    promise<T> with_deadline(
+        promise<T> p,
+        timer_wheel::clock_type::time_point deadline,
+        timer_wheel& wheel = timer_wheel::shared());
+
+    template < typename T, typename Rep, typename Period >
+    promise<T> with_timeout(
+        promise<T> p,
+        const std::chrono::duration<Rep, Period>& timeout_duration,
+        timer_wheel& wheel = timer_wheel::shared());
+
+    // 'max_attempts' counts the first call too, with zero attempts
+    // 'fn' is never called and the result is rejected with an empty
+    // aggregate_exception, like 'make_hedged_promise' does
+    //
+    // every call after the first one is made on the wheel thread,
+    // so 'fn' should only start the operation and return its promise
+
+    struct retry_policy final {
+        std::size_t max_attempts{3u};
+        timer_wheel::clock_type::duration initial_delay{std::chrono::milliseconds(100)};
+        timer_wheel::clock_type::duration max_delay{std::chrono::seconds(10)};
+        double multiplier{2.0};
+        double jitter{0.5};
+        std::function<bool(std::exception_ptr)> retryable;
+    };
+
+    template < typename F
+             , typename R = typename std::invoke_result_t<std::decay_t<F>>::value_type >
+    promise<R> retry(
+        F&& fn,
+        retry_policy policy = retry_policy(),
+        timer_wheel& wheel = timer_wheel::shared());
+
+    // like 'fn' of 'retry', 'launch_fn' is called on the wheel thread
+    // for every attempt but the first and should return promptly
+
+    template < typename F, typename Rep, typename Period
+             , typename R = typename std::invoke_result_t<std::decay_t<F>>::value_type >
+    promise<R> make_hedged_promise(
+        F&& launch_fn,
+        const std::chrono::duration<Rep, Period>& delay,
+        std::size_t max_attempts,
+        timer_wheel& wheel = timer_wheel::shared());
+}
+
+namespace timer_hpp
+{
+    inline timer_wheel::timer_wheel(clock_type::duration tick)
+    : tick_(std::max(tick, clock_type::duration(1)))
+    , start_time_(clock_type::now()) {
+        slots_.fill(npos);
+        thread_ = std::thread(&timer_wheel::worker_main_, this);
+    }
+
+    inline timer_wheel::~timer_wheel() noexcept {
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            stopped_ = true;
+            cond_var_.notify_all();
+        }
+        if ( thread_.joinable() ) {
+            thread_.join();
+        }
+    }
+
+    inline timer_wheel& timer_wheel::shared() {
+        static timer_wheel wheel;
+        return wheel;
+    }
+
+    template < typename F >
+    timer_wheel::timer_id timer_wheel::schedule_at(clock_type::time_point time, F&& f) {
+        std::lock_guard<std::mutex> guard(mutex_);
+        if ( !timer_count_ ) {
+            current_tick_ = std::max(current_tick_, now_tick_());
+            cond_var_.notify_all();
+        }
+        const std::size_t index = acquire_timer_();
+        timer& t = timers_[index];
+        try {
+            t.callback = std::forward<F>(f);
+        } catch (...) {
+            release_timer_(index);
+            throw;
+        }
+        t.expiry = std::max(time_to_tick_(time), current_tick_ + 1u);
+        link_timer_(index);
+        ++timer_count_;
+        if ( t.expiry < wake_tick_ ) {
+            cond_var_.notify_all();
+        }
+        return timer_id(index, t.generation);
+    }
+
+    template < typename Rep, typename Period, typename F >
+    timer_wheel::timer_id timer_wheel::schedule_after(
+        const std::chrono::duration<Rep, Period>& duration, F&& f)
+    {
+        return schedule_at(
+            clock_type::now() + std::chrono::duration_cast<clock_type::duration>(duration),
+            std::forward<F>(f));
+    }
+
+    inline bool timer_wheel::cancel(timer_id id) noexcept {
+        callback_t callback;
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            if ( id.index_ >= timers_.size() ) {
+                return false;
+            }
+            timer& t = timers_[id.index_];
+            if ( t.generation != id.generation_ || t.slot == npos ) {
+                return false;
+            }
+            unlink_timer_(id.index_);
+            callback = std::move(t.callback);
+            release_timer_(id.index_);
+            --timer_count_;
+        }
+        return true;
+    }
+
+    inline std::size_t timer_wheel::timer_count() const noexcept {
+        std::lock_guard<std::mutex> guard(mutex_);
+        return timer_count_;
+    }
+
+    inline timer_wheel::clock_type::duration timer_wheel::tick() const noexcept {
+        return tick_;
+    }
+
+    inline std::uint64_t timer_wheel::now_tick_() const noexcept {
+        return static_cast<std::uint64_t>((clock_type::now() - start_time_) / tick_);
+    }
+
+    inline std::uint64_t timer_wheel::time_to_tick_(clock_type::time_point time) const noexcept {
+        if ( time <= start_time_ ) {
+            return 0u;
+        }
+        return static_cast<std::uint64_t>(
+            (time - start_time_ + tick_ - clock_type::duration(1)) / tick_);
+    }
+
+    inline std::size_t timer_wheel::acquire_timer_() {
+        if ( free_timers_ == npos ) {
+            timers_.emplace_back();
+            return timers_.size() - 1u;
+        }
+        const std::size_t index = free_timers_;
+        free_timers_ = timers_[index].next;
+        return index;
+    }
+
+    inline void timer_wheel::release_timer_(std::size_t index) noexcept {
+        timer& t = timers_[index];
+        t.callback = nullptr;
+        t.slot = npos;
+        t.prev = npos;
+        t.next = free_timers_;
+        ++t.generation;
+        free_timers_ = index;
+    }
+
+    inline void timer_wheel::link_timer_(std::size_t index) noexcept {
+        timer& t = timers_[index];
+        t.expiry = std::max(t.expiry, current_tick_);
+        const std::uint64_t delta = std::min(t.expiry - current_tick_, max_delta);
+        const std::uint64_t expiry = current_tick_ + delta;
+
+        std::size_t level = 0u;
+        while ( level + 1u < level_count && (delta >> (level_bits * (level + 1u))) ) {
+            ++level;
+        }
+
+        const auto slot = static_cast<std::size_t>(expiry >> (level_bits * level)) & slot_mask;
+        t.slot = level * slot_count + slot;
+        t.prev = npos;
+        t.next = slots_[t.slot];
+        if ( t.next != npos ) {
+            timers_[t.next].prev = index;
+        }
+        slots_[t.slot] = index;
+    }
+
+    inline void timer_wheel::unlink_timer_(std::size_t index) noexcept {
+        timer& t = timers_[index];
+        if ( t.prev != npos ) {
+            timers_[t.prev].next = t.next;
+        } else {
+            slots_[t.slot] = t.next;
+        }
+        if ( t.next != npos ) {
+            timers_[t.next].prev = t.prev;
+        }
+    }
+
+    inline void timer_wheel::advance_tick_(std::vector<callback_t>& expired) {
+        const std::uint64_t tick = ++current_tick_;
+
+        for ( std::size_t level = level_count - 1u; level > 0u; --level ) {
+            const std::size_t shift = level_bits * level;
+            if ( tick & ((std::uint64_t{1u} << shift) - 1u) ) {
+                continue;
+            }
+            const std::size_t slot = level * slot_count
+                + (static_cast<std::size_t>(tick >> shift) & slot_mask);
+            std::size_t index = std::exchange(slots_[slot], npos);
+            while ( index != npos ) {
+                const std::size_t next = timers_[index].next;
+                link_timer_(index);
+                index = next;
+            }
+        }
+
+        const std::size_t slot = static_cast<std::size_t>(tick) & slot_mask;
+        std::size_t index = std::exchange(slots_[slot], npos);
+        while ( index != npos ) {
+            const std::size_t next = timers_[index].next;
+            expired.push_back(std::move(timers_[index].callback));
+            release_timer_(index);
+            --timer_count_;
+            index = next;
+        }
+    }
+
+    // the next tick that expires timers or cascades a higher level, every
+    // timer of level 'l' expires within the next 64 slots of that level
+
+    inline std::uint64_t timer_wheel::next_event_tick_() const noexcept {
+        std::uint64_t next_tick = std::numeric_limits<std::uint64_t>::max();
+        for ( std::size_t level = 0u; level < level_count; ++level ) {
+            const std::size_t shift = level_bits * level;
+            const std::uint64_t base = current_tick_ >> shift;
+            for ( std::uint64_t i = 1u; i <= slot_count; ++i ) {
+                const std::uint64_t tick = (base + i) << shift;
+                if ( tick >= next_tick ) {
+                    break;
+                }
+                const std::size_t slot = level * slot_count
+                    + (static_cast<std::size_t>(base + i) & slot_mask);
+                if ( slots_[slot] != npos ) {
+                    next_tick = tick;
+                    break;
+                }
+            }
+        }
+        return next_tick;
+    }
+
+    // the worker sleeps until the next event instead of waking on every
+    // tick and skips the empty ticks in between, 'schedule_at' wakes it
+    // up when a new timer expires before that
+
+    inline void timer_wheel::worker_main_() noexcept {
+        std::vector<callback_t> expired;
+        std::unique_lock<std::mutex> lock(mutex_);
+        while ( !stopped_ ) {
+            if ( !timer_count_ ) {
+                cond_var_.wait(lock, [this](){
+                    return stopped_ || timer_count_;
+                });
+                continue;
+            }
+
+            wake_tick_ = next_event_tick_();
+            cond_var_.wait_until(lock, start_time_ + tick_ * static_cast<clock_type::rep>(wake_tick_));
+            wake_tick_ = 0u;
+            if ( stopped_ ) {
+                break;
+            }
+
+            const std::uint64_t now_tick = now_tick_();
+            while ( timer_count_ && current_tick_ < now_tick ) {
+                const std::uint64_t next_tick = next_event_tick_();
+                if ( next_tick > now_tick ) {
+                    current_tick_ = now_tick;
+                    break;
+                }
+                current_tick_ = next_tick - 1u;
+                advance_tick_(expired);
+            }
+
+            if ( !expired.empty() ) {
+                lock.unlock();
+                for ( callback_t& callback : expired ) {
+                    callback();
+                }
+                expired.clear();
+                lock.lock();
+            }
+        }
+    }
+}
+
+namespace timer_hpp
+{
+    namespace impl
+    {
+        template < typename T >
+        class deadline_context_t final : private detail::noncopyable {
+        public:
+            deadline_context_t(promise<T> result, timer_wheel& wheel)
+            : result_(std::move(result))
+            , wheel_(wheel)
+            , subscriptions_(1u) {}
+
+            template < typename... Args >
+            void apply_result(Args&&... args) noexcept {
+                try {
+                    if ( result_.resolve(std::forward<Args>(args)...) ) {
+                        wheel_.cancel(timer_);
+                    }
+                } catch (...) {
+                    apply_exception(std::current_exception());
+                }
+            }
+
+            void apply_exception(std::exception_ptr e) noexcept {
+                if ( result_.reject(e) ) {
+                    wheel_.cancel(timer_);
+                }
+            }
+
+            void apply_timeout() noexcept {
+                if ( result_.reject(std::make_exception_ptr(timeout_exception())) ) {
+                    subscriptions_.detach();
+                }
+            }
+
+            void apply_cancel() noexcept {
+                wheel_.cancel(timer_);
+                subscriptions_.detach();
+            }
+
+            void set_timer(timer_wheel::timer_id timer) noexcept {
+                timer_ = timer;
+            }
+
+            void add_subscription(promise_subscription subscription) {
+                subscriptions_.add(std::move(subscription));
+            }
+        private:
+            promise<T> result_;
+            timer_wheel& wheel_;
+            timer_wheel::timer_id timer_;
+            promise_hpp::impl::detachable_subscriptions_t subscriptions_;
+        };
+    }
+
+    template < typename T >
+    promise<T> with_deadline(
+        promise<T> p,
+        timer_wheel::clock_type::time_point deadline,
+        timer_wheel& wheel)
+    {
+        using context_t = impl::deadline_context_t<T>;
+
+        promise<T> result;
+
+        try {
+            auto context = std::make_shared<context_t>(result, wheel);
+            context->set_timer(wheel.schedule_at(deadline, [context](){
+                context->apply_timeout();
+            }));
+            if constexpr ( std::is_void_v<T> ) {
+                context->add_subscription(p.subscribe([context](){
+                    context->apply_result();
+                }, [context](std::exception_ptr e){
+                    context->apply_exception(e);
+                }));
+            } else {
+                context->add_subscription(p.subscribe([context](auto&& v){
+                    context->apply_result(std::forward<decltype(v)>(v));
+                }, [context](std::exception_ptr e){
+                    context->apply_exception(e);
+                }));
+            }
+            result.on_cancel([weak_context = std::weak_ptr<context_t>(context)](){
+                if ( auto context = weak_context.lock() ) {
+                    context->apply_cancel();
+                }
+            });
+        } catch (...) {
+            result.reject(std::current_exception());
+        }
+
+        return result;
+    }
+
+    template < typename T, typename Rep, typename Period >
+    promise<T> with_timeout(
+        promise<T> p,
+        const std::chrono::duration<Rep, Period>& timeout_duration,
+        timer_wheel& wheel)
+    {
+        return with_deadline(
+            std::move(p),
+            timer_wheel::clock_type::now()
+                + std::chrono::duration_cast<timer_wheel::clock_type::duration>(timeout_duration),
+            wheel);
+    }
+
+    //
+    // make_hedged_promise
+    //
+
+    namespace impl
+    {
+        template < typename T, typename F >
+        class hedged_promise_context_t final
+            : private detail::noncopyable
+            , public std::enable_shared_from_this<hedged_promise_context_t<T, F>> {
+        public:
+            template < typename U >
+            hedged_promise_context_t(
+                promise<T> result,
+                U&& launch_fn,
+                timer_wheel::clock_type::duration delay,
+                std::size_t max_attempts,
+                timer_wheel& wheel)
+            : result_(std::move(result))
+            , launch_fn_(std::forward<U>(launch_fn))
+            , delay_(delay)
+            , max_attempts_(max_attempts)
+            , wheel_(wheel)
+            , exceptions_(max_attempts)
+            , subscriptions_(max_attempts) {}
+
+            // only the attempt index is reserved under the lock, 'launch_fn_'
+            // runs outside of it and may be called from several threads
+
+            void launch_next() noexcept {
+                std::size_t index = 0;
+                {
+                    std::lock_guard<std::mutex> guard(mutex_);
+                    if ( settled_ || launched_ == max_attempts_ ) {
+                        return;
+                    }
+                    index = launched_++;
+                }
+                promise<T> attempt;
+                try {
+                    if ( index + 1u < max_attempts_ ) {
+                        arm_timer_();
+                    }
+                    attempt = std::invoke(launch_fn_);
+                } catch (...) {
+                    apply_exception(index, std::current_exception());
+                    return;
+                }
+                try {
+                    const auto self = this->shared_from_this();
+                    if constexpr ( std::is_void_v<T> ) {
+                        subscriptions_.add(attempt.subscribe([self](){
+                            self->apply_result();
+                        }, [self, index](std::exception_ptr e){
+                            self->apply_exception(index, e);
+                        }));
+                    } else {
+                        subscriptions_.add(attempt.subscribe([self](auto&& v){
+                            self->apply_result(std::forward<decltype(v)>(v));
+                        }, [self, index](std::exception_ptr e){
+                            self->apply_exception(index, e);
+                        }));
+                    }
+                } catch (...) {
+                    apply_exception(index, std::current_exception());
+                }
+            }
+
+            template < typename... Args >
+            void apply_result(Args&&... args) noexcept {
+                if ( !settle_() ) {
+                    return;
+                }
+                try {
+                    result_.resolve(std::forward<Args>(args)...);
+                } catch (...) {
+                    result_.reject(std::current_exception());
+                }
+                subscriptions_.detach();
+            }
+
+            void apply_exception(std::size_t index, std::exception_ptr e) noexcept {
+                bool all_failed = false;
+                bool all_launched_failed = false;
+                {
+                    std::lock_guard<std::mutex> guard(mutex_);
+                    if ( settled_ ) {
+                        return;
+                    }
+                    exceptions_[index] = e;
+                    ++failures_;
+                    all_failed = failures_ == max_attempts_;
+                    all_launched_failed = failures_ == launched_;
+                }
+                if ( all_failed ) {
+                    if ( settle_() ) {
+                        try {
+                            result_.reject(aggregate_exception(std::move(exceptions_)));
+                        } catch (...) {
+                            result_.reject(std::current_exception());
+                        }
+                    }
+                } else if ( all_launched_failed ) {
+                    launch_next();
+                }
+            }
+
+            void apply_cancel() noexcept {
+                if ( settle_() ) {
+                    subscriptions_.detach();
+                }
+            }
+        private:
+            // the timer of the next attempt restarts after every launch,
+            // the replaced one is cancelled outside of the lock
+
+            void arm_timer_() {
+                const timer_wheel::timer_id timer = wheel_.schedule_after(
+                    delay_,
+                    [self = this->shared_from_this()](){
+                        self->launch_next();
+                    });
+                timer_wheel::timer_id stale_timer = timer;
+                {
+                    std::lock_guard<std::mutex> guard(mutex_);
+                    if ( !settled_ ) {
+                        stale_timer = std::exchange(timer_, timer);
+                    }
+                }
+                wheel_.cancel(stale_timer);
+            }
+
+            bool settle_() noexcept {
+                timer_wheel::timer_id timer;
+                {
+                    std::lock_guard<std::mutex> guard(mutex_);
+                    if ( settled_ ) {
+                        return false;
+                    }
+                    settled_ = true;
+                    timer = timer_;
+                }
+                wheel_.cancel(timer);
+                return true;
+            }
+        private:
+            promise<T> result_;
+            F launch_fn_;
+            const timer_wheel::clock_type::duration delay_;
+            const std::size_t max_attempts_;
+            timer_wheel& wheel_;
+            std::mutex mutex_;
+            bool settled_{false};
+            std::size_t launched_{0u};
+            std::size_t failures_{0u};
+            timer_wheel::timer_id timer_;
+            std::vector<std::exception_ptr> exceptions_;
+            promise_hpp::impl::detachable_subscriptions_t subscriptions_;
+        };
+    }
+
+    template < typename F, typename Rep, typename Period, typename R >
+    promise<R> make_hedged_promise(
+        F&& launch_fn,
+        const std::chrono::duration<Rep, Period>& delay,
+        std::size_t max_attempts,
+        timer_wheel& wheel)
+    {
+        static_assert(
+            is_promise_r<R, std::invoke_result_t<std::decay_t<F>>>::value,
+            "launch function must return a promise");
+
+        if ( !max_attempts ) {
+            return make_rejected_promise<R>(aggregate_exception());
+        }
+
+        using context_t = impl::hedged_promise_context_t<R, std::decay_t<F>>;
+
+        promise<R> result;
+
+        try {
+            auto context = std::make_shared<context_t>(
+                result,
+                std::forward<F>(launch_fn),
+                std::chrono::duration_cast<timer_wheel::clock_type::duration>(delay),
+                max_attempts,
+                wheel);
+            result.on_cancel([weak_context = std::weak_ptr<context_t>(context)](){
+                if ( auto context = weak_context.lock() ) {
+                    context->apply_cancel();
+                }
+            });
+            context->launch_next();
+        } catch (...) {
+            result.reject(std::current_exception());
+        }
+
+        return result;
+    }
+
+    //
+    // retry
+    //
+
+    namespace impl
+    {
+        template < typename T, typename F >
+        class retry_context_t final
+            : private detail::noncopyable
+            , public std::enable_shared_from_this<retry_context_t<T, F>> {
+        public:
+            template < typename U >
+            retry_context_t(
+                promise<T> result,
+                U&& fn,
+                retry_policy policy,
+                timer_wheel& wheel)
+            : result_(std::move(result))
+            , fn_(std::forward<U>(fn))
+            , policy_(std::move(policy))
+            , wheel_(wheel)
+            , delay_(static_cast<double>(policy_.initial_delay.count()))
+            , random_(std::random_device()()) {}
+
+            void launch_next() noexcept {
+                if ( result_.is_cancelled() ) {
+                    return;
+                }
+                try {
+                    ++attempts_;
+                    const auto self = this->shared_from_this();
+                    if constexpr ( std::is_void_v<T> ) {
+                        std::invoke(fn_).subscribe([self](){
+                            self->result_.resolve();
+                        }, [self](std::exception_ptr e){
+                            self->apply_exception(e);
+                        });
+                    } else {
+                        std::invoke(fn_).subscribe([self](auto&& v){
+                            self->apply_result(std::forward<decltype(v)>(v));
+                        }, [self](std::exception_ptr e){
+                            self->apply_exception(e);
+                        });
+                    }
+                } catch (...) {
+                    apply_exception(std::current_exception());
+                }
+            }
+        private:
+            template < typename U >
+            void apply_result(U&& value) noexcept {
+                try {
+                    result_.resolve(std::forward<U>(value));
+                } catch (...) {
+                    result_.reject(std::current_exception());
+                }
+            }
+
+            void apply_exception(std::exception_ptr e) noexcept {
+                try {
+                    if ( attempts_ >= policy_.max_attempts || !is_retryable_(e) ) {
+                        result_.reject(e);
+                        return;
+                    }
+                    wheel_.schedule_after(next_delay_(), [self = this->shared_from_this()](){
+                        self->launch_next();
+                    });
+                } catch (...) {
+                    result_.reject(std::current_exception());
+                }
+            }
+
+            bool is_retryable_(std::exception_ptr e) const {
+                return !policy_.retryable || policy_.retryable(e);
+            }
+
+            timer_wheel::clock_type::duration next_delay_() {
+                using duration_t = timer_wheel::clock_type::duration;
+                const double max_delay = static_cast<double>(policy_.max_delay.count());
+                const double delay = std::min(delay_, max_delay);
+                delay_ = std::min(delay_ * std::max(policy_.multiplier, 1.0), max_delay);
+                const double jitter = std::clamp(policy_.jitter, 0.0, 1.0);
+                const double factor = 1.0 - jitter * std::uniform_real_distribution<double>()(random_);
+                return duration_t(static_cast<duration_t::rep>(delay * factor));
+            }
+        private:
+            promise<T> result_;
+            F fn_;
+            const retry_policy policy_;
+            timer_wheel& wheel_;
+            std::size_t attempts_{0u};
+            double delay_{0.0};
+            std::minstd_rand random_;
+        };
+    }
+
+    template < typename F, typename R >
+    promise<R> retry(F&& fn, retry_policy policy, timer_wheel& wheel) {
+        static_assert(
+            is_promise_r<R, std::invoke_result_t<std::decay_t<F>>>::value,
+            "retry function must return a promise");
+
+        if ( !policy.max_attempts ) {
+            return make_rejected_promise<R>(aggregate_exception());
+        }
+
+        using context_t = impl::retry_context_t<R, std::decay_t<F>>;
+
+        promise<R> result;
+
+        try {
+            auto context = std::make_shared<context_t>(
+                result,
+                std::forward<F>(fn),
+                std::move(policy),
+                wheel);
+            context->launch_next();
+        } catch (...) {
+            result.reject(std::current_exception());
+        }
+
+        return result;
+    }
+}
@@ -10,6 +10,9 @@
 #include <cassert>
 
 #include <new>
+#include <array>
+#include <deque>
+#include <algorithm>
 #include <tuple>
 #include <mutex>
 #include <atomic>
@@ -17,6 +20,7 @@
 #include <chrono>
 #include <memory>
 #include <vector>
+#include <variant>
 #include <utility>
 #include <iterator>
 #include <exception>
@@ -134,6 +138,116 @@ namespace promise_hpp
     private:
         internal_state_t state_;
     };
+
+    //
+    // promise_cancelled_exception
+    //
+
+    class promise_cancelled_exception final : public std::runtime_error {
+    public:
+        promise_cancelled_exception()
+        : std::runtime_error("promise has been cancelled") {}
+    };
+
+    //
+    // settled_result
+    //
+
+    template < typename T >
+    class settled_result final {
+    public:
+        using value_type = T;
+
+        settled_result() = default;
+
+        explicit settled_result(std::exception_ptr e) noexcept
+        : state_(std::in_place_index<2>, e) {}
+
+        template < typename U
+                 , typename = std::enable_if_t<
+                    !std::is_same_v<std::decay_t<U>, settled_result> &&
+                    !std::is_same_v<std::decay_t<U>, std::exception_ptr>> >
+        explicit settled_result(U&& value)
+        : state_(std::in_place_index<1>, make_value_(std::forward<U>(value))) {}
+
+        bool is_resolved() const noexcept {
+            return state_.index() == 1;
+        }
+
+        bool is_rejected() const noexcept {
+            return state_.index() == 2;
+        }
+
+        const T& value() const {
+            if ( is_rejected() ) {
+                std::rethrow_exception(std::get<2>(state_));
+            }
+            assert(is_resolved());
+            if constexpr ( std::is_reference_v<T> ) {
+                return *std::get<1>(state_);
+            } else {
+                return std::get<1>(state_);
+            }
+        }
+
+        std::exception_ptr exception() const noexcept {
+            return is_rejected()
+                ? std::get<2>(state_)
+                : nullptr;
+        }
+    private:
+        using value_t = std::conditional_t<
+            std::is_reference_v<T>,
+            std::remove_reference_t<T>*,
+            T>;
+
+        template < typename U >
+        static value_t make_value_(U&& value) {
+            if constexpr ( std::is_reference_v<T> ) {
+                return std::addressof(value);
+            } else {
+                return value_t(std::forward<U>(value));
+            }
+        }
+    private:
+        std::variant<std::monostate, value_t, std::exception_ptr> state_;
+    };
+
+    template <>
+    class settled_result<void> final {
+    public:
+        using value_type = void;
+
+        settled_result() = default;
+
+        explicit settled_result(std::in_place_t) noexcept
+        : resolved_(true) {}
+
+        explicit settled_result(std::exception_ptr e) noexcept
+        : exception_(e) {}
+
+        bool is_resolved() const noexcept {
+            return resolved_;
+        }
+
+        bool is_rejected() const noexcept {
+            return !!exception_;
+        }
+
+        void value() const {
+            if ( is_rejected() ) {
+                std::rethrow_exception(exception_);
+            }
+            assert(is_resolved());
+        }
+
+        std::exception_ptr exception() const noexcept {
+            return exception_;
+        }
+    private:
+        bool resolved_{false};
+        std::exception_ptr exception_{nullptr};
+    };
 }
 
 // -----------------------------------------------------------------------------
@@ -164,6 +278,396 @@ namespace promise_hpp::detail
         ~noncopyable() = default;
     };
 
+    class cancellable_state {
+    public:
+        virtual bool cancel() noexcept = 0;
+        virtual void release_consumer() noexcept = 0;
+    protected:
+        cancellable_state() = default;
+        ~cancellable_state() = default;
+    };
+
+    class intrusive_list_hook : private noncopyable {
+    protected:
+        intrusive_list_hook() = default;
+        ~intrusive_list_hook() = default;
+    private:
+        template < typename Node >
+        friend class intrusive_list;
+        intrusive_list_hook* prev_{nullptr};
+        intrusive_list_hook* next_{nullptr};
+    };
+
+    template < typename Node >
+    class intrusive_list final : private noncopyable {
+    public:
+        intrusive_list() = default;
+
+        ~intrusive_list() noexcept {
+            clear();
+        }
+
+        bool empty() const noexcept {
+            return !head_;
+        }
+
+        Node* push_back(std::unique_ptr<Node> node) noexcept {
+            intrusive_list_hook* hook = node.release();
+            hook->prev_ = tail_;
+            hook->next_ = nullptr;
+            if ( tail_ ) {
+                tail_->next_ = hook;
+            } else {
+                head_ = hook;
+            }
+            tail_ = hook;
+            return static_cast<Node*>(hook);
+        }
+
+        void erase(Node* node) noexcept {
+            intrusive_list_hook* hook = node;
+            if ( hook->prev_ ) {
+                hook->prev_->next_ = hook->next_;
+            } else {
+                head_ = hook->next_;
+            }
+            if ( hook->next_ ) {
+                hook->next_->prev_ = hook->prev_;
+            } else {
+                tail_ = hook->prev_;
+            }
+            delete node;
+        }
+
+        void swap(intrusive_list& other) noexcept {
+            std::swap(head_, other.head_);
+            std::swap(tail_, other.tail_);
+        }
+
+        void clear() noexcept {
+            while ( head_ ) {
+                intrusive_list_hook* next = head_->next_;
+                delete static_cast<Node*>(head_);
+                head_ = next;
+            }
+            tail_ = nullptr;
+        }
+
+        template < typename F >
+        void for_each(F&& f) const {
+            for ( intrusive_list_hook* hook = head_; hook; hook = hook->next_ ) {
+                f(*static_cast<Node*>(hook));
+            }
+        }
+    private:
+        intrusive_list_hook* head_{nullptr};
+        intrusive_list_hook* tail_{nullptr};
+    };
+
+    class subscribable_state {
+    public:
+        virtual bool unsubscribe(intrusive_list_hook* handler) noexcept = 0;
+    protected:
+        subscribable_state() = default;
+        ~subscribable_state() = default;
+    };
+
+    class sharded_countdown final : private noncopyable {
+    public:
+        explicit sharded_countdown(std::size_t count)
+        : root_counter_(count) {
+            const std::size_t shard_count = shard_count_for_(count);
+            if ( shard_count > 1 ) {
+                shards_ = std::vector<shard>(shard_count);
+                for ( std::size_t i = 0; i < shard_count; ++i ) {
+                    shards_[i].counter.store(
+                        count / shard_count + (i < count % shard_count ? 1u : 0u),
+                        std::memory_order_relaxed);
+                }
+                root_counter_.store(shard_count, std::memory_order_relaxed);
+            }
+        }
+
+        bool count_down(std::size_t index) noexcept {
+            if ( !shards_.empty() ) {
+                shard& s = shards_[index & (shards_.size() - 1u)];
+                if ( s.counter.fetch_sub(1u, std::memory_order_acq_rel) != 1u ) {
+                    return false;
+                }
+            }
+            return root_counter_.fetch_sub(1u, std::memory_order_acq_rel) == 1u;
+        }
+    private:
+        static constexpr std::size_t cache_line_size = 64u;
+        static constexpr std::size_t min_sharded_count = 1024u;
+        static constexpr std::size_t min_shard_capacity = 64u;
+
+        static std::size_t shard_count_for_(std::size_t count) noexcept {
+            if ( count < min_sharded_count ) {
+                return 1u;
+            }
+            const std::size_t threads = std::max(
+                std::size_t{1u},
+                static_cast<std::size_t>(std::thread::hardware_concurrency()));
+            const std::size_t limit = std::min(threads * 4u, count / min_shard_capacity);
+            std::size_t shard_count = 1u;
+            while ( shard_count * 2u <= limit ) {
+                shard_count *= 2u;
+            }
+            return shard_count;
+        }
+    private:
+        struct alignas(cache_line_size) shard {
+            std::atomic_size_t counter{0u};
+        };
+
+        std::vector<shard> shards_;
+        std::atomic_size_t root_counter_{0u};
+    };
+
+    // size-classed free lists with a per-thread cache in front of a
+    // shared depot, blocks move between them in batches so that one
+    // thread allocating and another one freeing rarely take the lock
+
+    class small_object_pool final : private noncopyable {
+    public:
+        static void* allocate(std::size_t size) {
+            const std::size_t index = class_index_(size);
+            if ( index == class_count ) {
+                return ::operator new(size);
+            }
+            thread_cache& cache = local_cache_();
+            if ( !cache.heads[index] ) {
+                depot_().take(index, cache);
+                if ( !cache.heads[index] ) {
+                    return ::operator new(class_size_(index));
+                }
+            }
+            free_block* block = cache.heads[index];
+            cache.heads[index] = block->next;
+            --cache.counts[index];
+            return block;
+        }
+
+        static void deallocate(void* ptr, std::size_t size) noexcept {
+            const std::size_t index = class_index_(size);
+            if ( index == class_count ) {
+                ::operator delete(ptr);
+                return;
+            }
+            thread_cache& cache = local_cache_();
+            free_block* block = static_cast<free_block*>(ptr);
+            block->next = cache.heads[index];
+            cache.heads[index] = block;
+            if ( ++cache.counts[index] > cache_capacity ) {
+                depot_().give(index, cache, cache_capacity / 2u);
+            }
+        }
+    private:
+        static constexpr std::size_t class_count = 3u;
+        static constexpr std::size_t min_class_size = 64u;
+        static constexpr std::size_t cache_capacity = 64u;
+        static constexpr std::size_t depot_capacity = 4096u;
+
+        static constexpr std::size_t class_size_(std::size_t index) noexcept {
+            return min_class_size << index;
+        }
+
+        static std::size_t class_index_(std::size_t size) noexcept {
+            std::size_t index = 0u;
+            while ( index < class_count && size > class_size_(index) ) {
+                ++index;
+            }
+            return index;
+        }
+    private:
+        struct free_block {
+            free_block* next;
+        };
+
+        struct thread_cache;
+
+        class depot final : private noncopyable {
+        public:
+            void take(std::size_t index, thread_cache& cache) noexcept {
+                std::lock_guard<std::mutex> guard(mutex_);
+                while ( heads_[index] && cache.counts[index] < cache_capacity / 2u ) {
+                    free_block* block = heads_[index];
+                    heads_[index] = block->next;
+                    --counts_[index];
+                    block->next = cache.heads[index];
+                    cache.heads[index] = block;
+                    ++cache.counts[index];
+                }
+            }
+
+            void give(std::size_t index, thread_cache& cache, std::size_t count) noexcept {
+                std::lock_guard<std::mutex> guard(mutex_);
+                while ( cache.heads[index] && count-- ) {
+                    free_block* block = cache.heads[index];
+                    cache.heads[index] = block->next;
+                    --cache.counts[index];
+                    if ( counts_[index] < depot_capacity ) {
+                        block->next = heads_[index];
+                        heads_[index] = block;
+                        ++counts_[index];
+                    } else {
+                        ::operator delete(block);
+                    }
+                }
+            }
+        private:
+            std::mutex mutex_;
+            std::array<free_block*, class_count> heads_{};
+            std::array<std::size_t, class_count> counts_{};
+        };
+
+        struct thread_cache final : private noncopyable {
+            std::array<free_block*, class_count> heads{};
+            std::array<std::size_t, class_count> counts{};
+
+            thread_cache() = default;
+
+            ~thread_cache() noexcept {
+                for ( std::size_t i = 0; i < class_count; ++i ) {
+                    depot_().give(i, *this, counts[i]);
+                }
+            }
+        };
+
+        static depot& depot_() noexcept {
+            // never destroyed, thread caches of threads that outlive
+            // static destruction still return their blocks here
+            static depot* instance = new depot();
+            return *instance;
+        }
+
+        static thread_cache& local_cache_() noexcept {
+            static thread_local thread_cache cache;
+            return cache;
+        }
+    };
+
+    // base of the type-erased tasks queued by the bonus executors,
+    // allocated from small_object_pool unless over-aligned
+
+    class pooled_task : private noncopyable {
+    public:
+        virtual ~pooled_task() noexcept = default;
+
+        static void* operator new(std::size_t size) {
+            return small_object_pool::allocate(size);
+        }
+
+        static void operator delete(void* ptr, std::size_t size) noexcept {
+            small_object_pool::deallocate(ptr, size);
+        }
+
+        static void* operator new(std::size_t size, std::align_val_t align) {
+            return ::operator new(size, align);
+        }
+
+        static void operator delete(void* ptr, std::size_t size, std::align_val_t align) noexcept {
+            ::operator delete(ptr, size, align);
+        }
+
+        virtual void run() noexcept = 0;
+        virtual void cancel() noexcept = 0;
+        virtual bool is_cancelled() const noexcept = 0;
+    };
+
+    // fire-and-forget task without a promise, exceptions go to
+    // the executor's error handler or are dropped without one
+
+    template < typename F, typename... Args >
+    class posted_task final : public pooled_task {
+    public:
+        using error_handler_t = std::function<void(std::exception_ptr)>;
+
+        template < typename U >
+        posted_task(const error_handler_t* error_handler, U&& u, std::tuple<Args...>&& args)
+        : f_(std::forward<U>(u))
+        , args_(std::move(args))
+        , error_handler_(error_handler) {}
+
+        void run() noexcept final {
+            try {
+                std::apply(std::move(f_), std::move(args_));
+            } catch (...) {
+                if ( *error_handler_ ) {
+                    (*error_handler_)(std::current_exception());
+                }
+            }
+        }
+
+        void cancel() noexcept final {
+        }
+
+        bool is_cancelled() const noexcept final {
+            return false;
+        }
+    private:
+        F f_;
+        std::tuple<Args...> args_;
+        const error_handler_t* error_handler_;
+    };
+
+    // one FIFO ring buffer per priority level and a bitmask
+    // of the non-empty levels, both push and pop are O(1)
+
+    template < typename Priority, typename TaskPtr >
+    class priority_task_queue final : private noncopyable {
+    public:
+        bool empty() const noexcept {
+            return !non_empty_levels_;
+        }
+
+        void push(Priority priority, TaskPtr task) {
+            const std::size_t level = static_cast<std::size_t>(priority);
+            assert(level < level_count);
+            ring& r = levels_[level];
+            if ( r.size == r.slots.size() ) {
+                std::vector<TaskPtr> slots(std::max<std::size_t>(16u, r.slots.size() * 2u));
+                for ( std::size_t i = 0; i < r.size; ++i ) {
+                    slots[i] = std::move(r.slots[(r.head + i) & (r.slots.size() - 1u)]);
+                }
+                r.slots = std::move(slots);
+                r.head = 0u;
+            }
+            r.slots[(r.head + r.size) & (r.slots.size() - 1u)] = std::move(task);
+            ++r.size;
+            non_empty_levels_ |= static_cast<std::uint8_t>(1u << level);
+        }
+
+        TaskPtr pop() noexcept {
+            for ( std::size_t i = level_count; i > 0; --i ) {
+                const std::size_t level = i - 1u;
+                if ( non_empty_levels_ & (1u << level) ) {
+                    ring& r = levels_[level];
+                    TaskPtr task = std::move(r.slots[r.head]);
+                    r.head = (r.head + 1u) & (r.slots.size() - 1u);
+                    if ( !--r.size ) {
+                        non_empty_levels_ &= static_cast<std::uint8_t>(~(1u << level));
+                    }
+                    return task;
+                }
+            }
+            return nullptr;
+        }
+    private:
+        struct ring final {
+            std::vector<TaskPtr> slots;
+            std::size_t head{0u};
+            std::size_t size{0u};
+        };
+        static constexpr std::size_t level_count =
+            static_cast<std::size_t>(Priority::highest) + 1u;
+        static_assert(level_count <= 8u, "unexpected priority count");
+    private:
+        std::array<ring, level_count> levels_;
+        std::uint8_t non_empty_levels_{0u};
+    };
+
     template < typename T >
     class storage final : private noncopyable {
     public:
@@ -243,68 +747,214 @@ namespace promise_hpp::detail
 
 // -----------------------------------------------------------------------------
 //
-// promise<T>
+// cancellation
 //
 // -----------------------------------------------------------------------------
 
 namespace promise_hpp
 {
-    template < typename T >
-    class promise final {
-    public:
-        using value_type = T;
+    namespace impl
+    {
+        class cancellation_state final : private detail::noncopyable {
+        public:
+            cancellation_state() = default;
 
-        promise()
-        : state_(std::make_shared<state>()) {}
+            bool is_cancelled() const noexcept {
+                return cancelled_.load(std::memory_order_acquire);
+            }
 
-        promise(promise&&) = default;
-        promise& operator=(promise&&) = default;
+            bool cancel() noexcept {
+                std::vector<callback_t> callbacks;
+                {
+                    std::lock_guard guard(mutex_);
+                    if ( cancelled_ ) {
+                        return false;
+                    }
+                    cancelled_.store(true, std::memory_order_release);
+                    callbacks.swap(callbacks_);
+                }
+                for ( const callback_t& c : callbacks ) {
+                    c();
+                }
+                return true;
+            }
 
-        promise(const promise&) = default;
-        promise& operator=(const promise&) = default;
+            template < typename F >
+            void subscribe(F&& f) {
+                std::unique_lock lock(mutex_);
+                if ( !cancelled_ ) {
+                    callbacks_.emplace_back(std::forward<F>(f));
+                    return;
+                }
+                lock.unlock();
+                std::invoke(std::forward<F>(f));
+            }
+        private:
+            using callback_t = std::function<void()>;
+            std::atomic<bool> cancelled_{false};
+            std::mutex mutex_;
+            std::vector<callback_t> callbacks_;
+        };
+    }
 
-        void swap(promise& other) noexcept {
-            state_.swap(other.state_);
-        }
+    class cancellation_token final {
+    public:
+        cancellation_token() = default;
 
-        std::size_t hash() const noexcept {
-            return std::hash<state*>()(state_.get());
+        bool is_cancelled() const noexcept {
+            return state_ && state_->is_cancelled();
         }
 
-        friend bool operator<(const promise& l, const promise& r) noexcept {
-            return l.state_ < r.state_;
+        bool can_be_cancelled() const noexcept {
+            return !!state_;
         }
 
-        friend bool operator==(const promise& l, const promise& r) noexcept {
-            return l.state_ == r.state_;
-        }
+        // callbacks are invoked once on cancellation or right away
+        // if the token is already cancelled, they must not throw
 
-        friend bool operator!=(const promise& l, const promise& r) noexcept {
-            return l.state_ != r.state_;
+        template < typename F >
+        void on_cancel(F&& f) const {
+            if ( state_ ) {
+                state_->subscribe(std::forward<F>(f));
+            }
         }
+    private:
+        friend class cancellation_source;
+        using state_ptr = std::shared_ptr<impl::cancellation_state>;
 
-        //
-        // get
-        //
+        explicit cancellation_token(state_ptr state) noexcept
+        : state_(std::move(state)) {}
+    private:
+        state_ptr state_;
+    };
 
-        const T& get() const {
-            return state_->get();
-        }
+    class cancellation_source final {
+    public:
+        cancellation_source()
+        : state_(std::make_shared<impl::cancellation_state>()) {}
 
-        template < typename U >
-        T get_or_default(U&& def) const {
-            try {
-                return get();
-            } catch (...) {
-                return std::forward<U>(def);
-            }
+        cancellation_token token() const noexcept {
+            return cancellation_token(state_);
         }
 
-        //
-        // wait
-        //
+        bool cancel() noexcept {
+            const auto state = state_;
+            return state->cancel();
+        }
 
-        void wait() const noexcept {
+        bool is_cancelled() const noexcept {
+            return state_->is_cancelled();
+        }
+    private:
+        std::shared_ptr<impl::cancellation_state> state_;
+    };
+}
+
+// -----------------------------------------------------------------------------
+//
+// promise_subscription
+//
+// -----------------------------------------------------------------------------
+
+namespace promise_hpp
+{
+    class promise_subscription final {
+    public:
+        promise_subscription() = default;
+
+        promise_subscription(promise_subscription&&) noexcept = default;
+        promise_subscription& operator=(promise_subscription&&) noexcept = default;
+
+        promise_subscription(const promise_subscription&) = delete;
+        promise_subscription& operator=(const promise_subscription&) = delete;
+
+        // removes the handlers from a pending promise, returns false
+        // if the promise is already settled or the handlers are removed
+
+        bool unsubscribe() noexcept {
+            const auto state = state_.lock();
+            state_.reset();
+            return state && state->unsubscribe(handler_);
+        }
+    private:
+        template < typename T >
+        friend class promise;
+
+        promise_subscription(
+            std::weak_ptr<detail::subscribable_state> state,
+            detail::intrusive_list_hook* handler) noexcept
+        : state_(std::move(state))
+        , handler_(handler) {}
+    private:
+        std::weak_ptr<detail::subscribable_state> state_;
+        detail::intrusive_list_hook* handler_{nullptr};
+    };
+}
+
+// -----------------------------------------------------------------------------
+//
+// promise<T>
+//
+// -----------------------------------------------------------------------------
+
+namespace promise_hpp
+{
+    template < typename T >
+    class promise final {
+    public:
+        using value_type = T;
+
+        promise()
+        : state_(std::make_shared<state>()) {}
+
+        promise(promise&&) = default;
+        promise& operator=(promise&&) = default;
+
+        promise(const promise&) = default;
+        promise& operator=(const promise&) = default;
+
+        void swap(promise& other) noexcept {
+            state_.swap(other.state_);
+        }
+
+        std::size_t hash() const noexcept {
+            return std::hash<state*>()(state_.get());
+        }
+
+        friend bool operator<(const promise& l, const promise& r) noexcept {
+            return l.state_ < r.state_;
+        }
+
+        friend bool operator==(const promise& l, const promise& r) noexcept {
+            return l.state_ == r.state_;
+        }
+
+        friend bool operator!=(const promise& l, const promise& r) noexcept {
+            return l.state_ != r.state_;
+        }
+
+        //
+        // get
+        //
+
+        const T& get() const {
+            return state_->get();
+        }
+
+        template < typename U >
+        T get_or_default(U&& def) const {
+            try {
+                return get();
+            } catch (...) {
+                return std::forward<U>(def);
+            }
+        }
+
+        //
+        // wait
+        //
+
+        void wait() const noexcept {
             state_->wait();
         }
 
@@ -322,18 +972,46 @@ namespace promise_hpp
         // resolve/reject
         //
 
+        // handlers are invoked after the promise lock is released and
+        // may drop the last reference to this promise, so the state is
+        // kept alive until they return
+
         template < typename U >
         bool resolve(U&& value) {
-            return state_->resolve(std::forward<U>(value));
+            const auto state = state_;
+            return state->resolve(std::forward<U>(value));
         }
 
         bool reject(std::exception_ptr e) noexcept {
-            return state_->reject(e);
+            const auto state = state_;
+            return state->reject(e);
         }
 
         template < typename E >
         bool reject(E&& e) {
-            return state_->reject(std::make_exception_ptr(std::forward<E>(e)));
+            return reject(std::make_exception_ptr(std::forward<E>(e)));
+        }
+
+        //
+        // cancel
+        //
+
+        bool cancel() noexcept {
+            const auto state = state_;
+            return state->cancel();
+        }
+
+        bool is_cancelled() const noexcept {
+            return state_->is_cancelled();
+        }
+
+        promise<T> cancel_on(const cancellation_token& token) {
+            token.on_cancel([s = std::weak_ptr<state>(state_)](){
+                if ( auto ss = s.lock() ) {
+                    ss->cancel();
+                }
+            });
+            return *this;
         }
 
         //
@@ -348,22 +1026,24 @@ namespace promise_hpp
         then(ResolveF&& on_resolve) {
             promise<typename ResolveR::value_type> next;
 
-            then([
+            auto tail = then([
                 n = next,
                 f = std::forward<ResolveF>(on_resolve)
             ](auto&& v) mutable {
                 auto np = std::invoke(
                     std::forward<decltype(f)>(f),
                     std::forward<decltype(v)>(v));
-                std::move(np).then([n](auto&&... nvs) mutable {
+                auto np_tail = std::move(np).then([n](auto&&... nvs) mutable {
                     n.resolve(std::forward<decltype(nvs)>(nvs)...);
                 }).except([n](std::exception_ptr e) mutable {
                     n.reject(e);
                 });
+                np_tail.link_downstream_(n);
             }).except([n = next](std::exception_ptr e) mutable {
                 n.reject(e);
             });
 
+            tail.link_downstream_(next);
             return next;
         }
 
@@ -433,6 +1113,7 @@ namespace promise_hpp
                 [](std::exception_ptr e) -> ResolveR { std::rethrow_exception(e); },
                 false);
 
+            link_downstream_(next);
             return next;
         }
 
@@ -451,6 +1132,7 @@ namespace promise_hpp
                 std::forward<RejectF>(on_reject),
                 true);
 
+            link_downstream_(next);
             return next;
         }
 
@@ -479,11 +1161,74 @@ namespace promise_hpp
                 std::rethrow_exception(e);
             });
         }
+
+        //
+        // subscribe
+        //
+
+        // registers raw handlers without creating a downstream promise,
+        // handlers must not throw and can be removed by the subscription
+
+        template < typename ResolveF, typename RejectF >
+        promise_subscription subscribe(ResolveF&& on_resolve, RejectF&& on_reject) {
+            detail::intrusive_list_hook* handler = state_->subscribe(
+                std::forward<ResolveF>(on_resolve),
+                std::forward<RejectF>(on_reject));
+            return handler
+                ? promise_subscription(state_, handler)
+                : promise_subscription();
+        }
+
+        //
+        // on_cancel
+        //
+
+        // registers a handler invoked if the promise gets cancelled, unlike
+        // 'subscribe' it does not hold off the cancellation by consumers,
+        // so owners of a result can release their resources with it
+
+        template < typename F >
+        promise_subscription on_cancel(F&& f) {
+            detail::intrusive_list_hook* handler = state_->on_cancel(
+                std::forward<F>(f));
+            return handler
+                ? promise_subscription(state_, handler)
+                : promise_subscription();
+        }
+    private:
+        template < typename U >
+        friend class promise;
+
+        template < typename U >
+        void link_downstream_(promise<U>& next) {
+            if ( state_->add_consumer() ) {
+                next.state_->set_upstream(state_);
+            }
+        }
     private:
         class state;
         std::shared_ptr<state> state_;
     private:
-        class state final : private detail::noncopyable {
+        class state final
+            : private detail::noncopyable
+            , public detail::cancellable_state
+            , public detail::subscribable_state {
+        private:
+            struct handler_t final : detail::intrusive_list_hook {
+                using resolve_t = std::function<void(const T&)>;
+                using reject_t = std::function<void(std::exception_ptr)>;
+
+                template < typename ResolveF, typename RejectF >
+                handler_t(ResolveF&& resolve, RejectF&& reject)
+                : resolve_(std::forward<ResolveF>(resolve))
+                , reject_(std::forward<RejectF>(reject)) {}
+
+                resolve_t resolve_;
+                reject_t reject_;
+                bool subscriber_{false};
+            };
+
+            using handler_list = detail::intrusive_list<handler_t>;
         public:
             state() = default;
 
@@ -492,7 +1237,7 @@ namespace promise_hpp
                 cond_var_.wait(lock, [this](){
                     return status_ != status::pending;
                 });
-                if ( status_ == status::rejected ) {
+                if ( status_ != status::resolved ) {
                     std::rethrow_exception(exception_);
                 }
                 assert(status_ == status::resolved);
@@ -524,28 +1269,103 @@ namespace promise_hpp
 
             template < typename U >
             bool resolve(U&& value) {
-                std::lock_guard guard(mutex_);
+                handler_list handlers;
+                {
+                    std::lock_guard guard(mutex_);
+                    if ( status_ != status::pending ) {
+                        return false;
+                    }
+                    storage_ = std::forward<U>(value);
+                    status_ = status::resolved;
+                    upstream_.reset();
+                    handlers.swap(handlers_);
+                }
+                invoke_resolve_handlers_(handlers);
+                cond_var_.notify_all();
+                return true;
+            }
+
+            bool reject(std::exception_ptr e) noexcept {
+                handler_list handlers;
+                {
+                    std::lock_guard guard(mutex_);
+                    if ( status_ != status::pending ) {
+                        return false;
+                    }
+                    exception_ = e;
+                    status_ = status::rejected;
+                    upstream_.reset();
+                    handlers.swap(handlers_);
+                }
+                invoke_reject_handlers_(handlers);
+                cond_var_.notify_all();
+                return true;
+            }
+
+            bool cancel() noexcept final {
                 if ( status_ != status::pending ) {
                     return false;
                 }
-                storage_ = std::forward<U>(value);
-                status_ = status::resolved;
-                invoke_resolve_handlers_();
+                handler_list handlers;
+                std::weak_ptr<detail::cancellable_state> upstream;
+                {
+                    std::lock_guard guard(mutex_);
+                    if ( status_ != status::pending ) {
+                        return false;
+                    }
+                    exception_ = std::make_exception_ptr(promise_cancelled_exception());
+                    status_ = status::cancelled;
+                    upstream.swap(upstream_);
+                    handlers.swap(handlers_);
+                }
+                invoke_reject_handlers_(handlers);
                 cond_var_.notify_all();
+                if ( auto s = upstream.lock() ) {
+                    s->release_consumer();
+                }
                 return true;
             }
 
-            bool reject(std::exception_ptr e) noexcept {
+            bool is_cancelled() const noexcept {
+                return status_ == status::cancelled;
+            }
+        public:
+            bool add_consumer() noexcept {
                 std::lock_guard guard(mutex_);
                 if ( status_ != status::pending ) {
                     return false;
                 }
-                exception_ = e;
-                status_ = status::rejected;
-                invoke_reject_handlers_();
-                cond_var_.notify_all();
+                ++consumers_;
+                orphaned_ = false;
                 return true;
             }
+
+            // the last released consumer cancels the promise, raw subscribers
+            // are consumers too, so the cancellation waits for them to leave
+
+            void release_consumer() noexcept final {
+                if ( status_ != status::pending ) {
+                    return;
+                }
+                {
+                    std::lock_guard guard(mutex_);
+                    if ( !consumers_ || --consumers_ ) {
+                        return;
+                    }
+                    if ( subscribers_ ) {
+                        orphaned_ = true;
+                        return;
+                    }
+                }
+                cancel();
+            }
+
+            void set_upstream(std::weak_ptr<detail::cancellable_state> upstream) noexcept {
+                std::lock_guard guard(mutex_);
+                if ( status_ == status::pending ) {
+                    upstream_ = std::move(upstream);
+                }
+            }
         public:
             template < typename U, typename ResolveF, typename RejectF >
             std::enable_if_t<std::is_void<U>::value, void>
@@ -583,7 +1403,6 @@ namespace promise_hpp
                     }
                 };
 
-                std::lock_guard guard(mutex_);
                 add_handlers_(std::move(resolve_h), std::move(reject_h));
             }
 
@@ -623,63 +1442,109 @@ namespace promise_hpp
                     }
                 };
 
-                std::lock_guard guard(mutex_);
                 add_handlers_(std::move(resolve_h), std::move(reject_h));
             }
+
+            template < typename ResolveF, typename RejectF >
+            detail::intrusive_list_hook* subscribe(ResolveF&& on_resolve, RejectF&& on_reject) {
+                return add_handlers_(
+                    std::forward<ResolveF>(on_resolve),
+                    std::forward<RejectF>(on_reject),
+                    true);
+            }
+
+            template < typename F >
+            detail::intrusive_list_hook* on_cancel(F&& f) {
+                return add_handlers_([](const T&){
+                }, [this, f = std::forward<F>(f)](std::exception_ptr) mutable {
+                    if ( status_ == status::cancelled ) {
+                        std::invoke(f);
+                    }
+                });
+            }
+
+            bool unsubscribe(detail::intrusive_list_hook* handler) noexcept final {
+                if ( status_ != status::pending ) {
+                    return false;
+                }
+                {
+                    std::lock_guard guard(mutex_);
+                    if ( status_ != status::pending ) {
+                        return false;
+                    }
+                    handler_t* h = static_cast<handler_t*>(handler);
+                    const bool subscriber = h->subscriber_;
+                    handlers_.erase(h);
+                    if ( !subscriber || --subscribers_ || !orphaned_ ) {
+                        return true;
+                    }
+                }
+                cancel();
+                return true;
+            }
         private:
             template < typename ResolveF, typename RejectF >
-            void add_handlers_(ResolveF&& resolve, RejectF&& reject) {
+            detail::intrusive_list_hook* add_handlers_(
+                ResolveF&& resolve,
+                RejectF&& reject,
+                bool subscriber = false)
+            {
+                std::unique_lock lock(mutex_);
+                if ( status_ == status::pending ) {
+                    handler_t* handler = handlers_.push_back(std::make_unique<handler_t>(
+                        std::forward<ResolveF>(resolve),
+                        std::forward<RejectF>(reject)));
+                    if ( subscriber ) {
+                        handler->subscriber_ = true;
+                        ++subscribers_;
+                    }
+                    return handler;
+                }
+                lock.unlock();
                 if ( status_ == status::resolved ) {
                     std::invoke(
                         std::forward<ResolveF>(resolve),
                         *storage_);
-                } else if ( status_ == status::rejected ) {
+                } else {
                     std::invoke(
                         std::forward<RejectF>(reject),
                         exception_);
-                } else {
-                    handlers_.push_back({
-                        std::forward<ResolveF>(resolve),
-                        std::forward<RejectF>(reject)});
                 }
+                return nullptr;
             }
 
-            void invoke_resolve_handlers_() noexcept {
-                for ( const auto& h : handlers_ ) {
+            void invoke_resolve_handlers_(const handler_list& handlers) noexcept {
+                handlers.for_each([this](const handler_t& h){
                     h.resolve_(*storage_);
-                }
-                handlers_.clear();
+                });
             }
 
-            void invoke_reject_handlers_() noexcept {
-                for ( const auto& h : handlers_ ) {
+            void invoke_reject_handlers_(const handler_list& handlers) noexcept {
+                handlers.for_each([this](const handler_t& h){
                     h.reject_(exception_);
-                }
-                handlers_.clear();
+                });
             }
         private:
             enum class status {
                 pending,
                 resolved,
-                rejected
+                rejected,
+                cancelled
             };
 
-            status status_{status::pending};
+            std::atomic<status> status_{status::pending};
             std::exception_ptr exception_{nullptr};
 
+            std::size_t consumers_{0u};
+            std::size_t subscribers_{0u};
+            bool orphaned_{false};
+            std::weak_ptr<detail::cancellable_state> upstream_;
+
             mutable std::mutex mutex_;
             mutable std::condition_variable cond_var_;
 
-            struct handler {
-                using resolve_t = std::function<void(const T&)>;
-                using reject_t = std::function<void(std::exception_ptr)>;
-
-                resolve_t resolve_;
-                reject_t reject_;
-            };
-
             detail::storage<T> storage_;
-            std::vector<handler> handlers_;
+            handler_list handlers_;
         };
     };
 }
@@ -764,17 +1629,45 @@ namespace promise_hpp
         // resolve/reject
         //
 
+        // handlers are invoked after the promise lock is released and
+        // may drop the last reference to this promise, so the state is
+        // kept alive until they return
+
         bool resolve() {
-            return state_->resolve();
+            const auto state = state_;
+            return state->resolve();
         }
 
         bool reject(std::exception_ptr e) noexcept {
-            return state_->reject(e);
+            const auto state = state_;
+            return state->reject(e);
         }
 
         template < typename E >
         bool reject(E&& e) {
-            return state_->reject(std::make_exception_ptr(std::forward<E>(e)));
+            return reject(std::make_exception_ptr(std::forward<E>(e)));
+        }
+
+        //
+        // cancel
+        //
+
+        bool cancel() noexcept {
+            const auto state = state_;
+            return state->cancel();
+        }
+
+        bool is_cancelled() const noexcept {
+            return state_->is_cancelled();
+        }
+
+        promise<void> cancel_on(const cancellation_token& token) {
+            token.on_cancel([s = std::weak_ptr<state>(state_)](){
+                if ( auto ss = s.lock() ) {
+                    ss->cancel();
+                }
+            });
+            return *this;
         }
 
         //
@@ -789,21 +1682,23 @@ namespace promise_hpp
         then(ResolveF&& on_resolve) {
             promise<typename ResolveR::value_type> next;
 
-            then([
+            auto tail = then([
                 n = next,
                 f = std::forward<ResolveF>(on_resolve)
             ]() mutable {
                 auto np = std::invoke(
                     std::forward<decltype(f)>(f));
-                std::move(np).then([n](auto&&... nvs) mutable {
+                auto np_tail = std::move(np).then([n](auto&&... nvs) mutable {
                     n.resolve(std::forward<decltype(nvs)>(nvs)...);
                 }).except([n](std::exception_ptr e) mutable {
                     n.reject(e);
                 });
+                np_tail.link_downstream_(n);
             }).except([n = next](std::exception_ptr e) mutable {
                 n.reject(e);
             });
 
+            tail.link_downstream_(next);
             return next;
         }
 
@@ -869,6 +1764,7 @@ namespace promise_hpp
                 [](std::exception_ptr e) -> ResolveR { std::rethrow_exception(e); },
                 false);
 
+            link_downstream_(next);
             return next;
         }
 
@@ -887,6 +1783,7 @@ namespace promise_hpp
                 std::forward<RejectF>(on_reject),
                 true);
 
+            link_downstream_(next);
             return next;
         }
 
@@ -914,11 +1811,74 @@ namespace promise_hpp
                 std::rethrow_exception(e);
             });
         }
+
+        //
+        // subscribe
+        //
+
+        // registers raw handlers without creating a downstream promise,
+        // handlers must not throw and can be removed by the subscription
+
+        template < typename ResolveF, typename RejectF >
+        promise_subscription subscribe(ResolveF&& on_resolve, RejectF&& on_reject) {
+            detail::intrusive_list_hook* handler = state_->subscribe(
+                std::forward<ResolveF>(on_resolve),
+                std::forward<RejectF>(on_reject));
+            return handler
+                ? promise_subscription(state_, handler)
+                : promise_subscription();
+        }
+
+        //
+        // on_cancel
+        //
+
+        // registers a handler invoked if the promise gets cancelled, unlike
+        // 'subscribe' it does not hold off the cancellation by consumers,
+        // so owners of a result can release their resources with it
+
+        template < typename F >
+        promise_subscription on_cancel(F&& f) {
+            detail::intrusive_list_hook* handler = state_->on_cancel(
+                std::forward<F>(f));
+            return handler
+                ? promise_subscription(state_, handler)
+                : promise_subscription();
+        }
+    private:
+        template < typename U >
+        friend class promise;
+
+        template < typename U >
+        void link_downstream_(promise<U>& next) {
+            if ( state_->add_consumer() ) {
+                next.state_->set_upstream(state_);
+            }
+        }
     private:
         class state;
         std::shared_ptr<state> state_;
     private:
-        class state final : private detail::noncopyable {
+        class state final
+            : private detail::noncopyable
+            , public detail::cancellable_state
+            , public detail::subscribable_state {
+        private:
+            struct handler_t final : detail::intrusive_list_hook {
+                using resolve_t = std::function<void()>;
+                using reject_t = std::function<void(std::exception_ptr)>;
+
+                template < typename ResolveF, typename RejectF >
+                handler_t(ResolveF&& resolve, RejectF&& reject)
+                : resolve_(std::forward<ResolveF>(resolve))
+                , reject_(std::forward<RejectF>(reject)) {}
+
+                resolve_t resolve_;
+                reject_t reject_;
+                bool subscriber_{false};
+            };
+
+            using handler_list = detail::intrusive_list<handler_t>;
         public:
             state() = default;
 
@@ -927,7 +1887,7 @@ namespace promise_hpp
                 cond_var_.wait(lock, [this](){
                     return status_ != status::pending;
                 });
-                if ( status_ == status::rejected ) {
+                if ( status_ != status::resolved ) {
                     std::rethrow_exception(exception_);
                 }
                 assert(status_ == status::resolved);
@@ -957,32 +1917,107 @@ namespace promise_hpp
             }
 
             bool resolve() {
-                std::lock_guard guard(mutex_);
-                if ( status_ != status::pending ) {
-                    return false;
+                handler_list handlers;
+                {
+                    std::lock_guard guard(mutex_);
+                    if ( status_ != status::pending ) {
+                        return false;
+                    }
+                    status_ = status::resolved;
+                    upstream_.reset();
+                    handlers.swap(handlers_);
                 }
-                status_ = status::resolved;
-                invoke_resolve_handlers_();
+                invoke_resolve_handlers_(handlers);
                 cond_var_.notify_all();
                 return true;
             }
 
             bool reject(std::exception_ptr e) noexcept {
-                std::lock_guard guard(mutex_);
-                if ( status_ != status::pending ) {
-                    return false;
+                handler_list handlers;
+                {
+                    std::lock_guard guard(mutex_);
+                    if ( status_ != status::pending ) {
+                        return false;
+                    }
+                    exception_ = e;
+                    status_ = status::rejected;
+                    upstream_.reset();
+                    handlers.swap(handlers_);
                 }
-                exception_ = e;
-                status_ = status::rejected;
-                invoke_reject_handlers_();
+                invoke_reject_handlers_(handlers);
                 cond_var_.notify_all();
                 return true;
             }
-        public:
-            template < typename U, typename ResolveF, typename RejectF >
-            std::enable_if_t<std::is_void<U>::value, void>
-            attach(promise<U>& next, ResolveF&& on_resolve, RejectF&& on_reject, bool has_reject) {
-                auto reject_h = [
+
+            bool cancel() noexcept final {
+                if ( status_ != status::pending ) {
+                    return false;
+                }
+                handler_list handlers;
+                std::weak_ptr<detail::cancellable_state> upstream;
+                {
+                    std::lock_guard guard(mutex_);
+                    if ( status_ != status::pending ) {
+                        return false;
+                    }
+                    exception_ = std::make_exception_ptr(promise_cancelled_exception());
+                    status_ = status::cancelled;
+                    upstream.swap(upstream_);
+                    handlers.swap(handlers_);
+                }
+                invoke_reject_handlers_(handlers);
+                cond_var_.notify_all();
+                if ( auto s = upstream.lock() ) {
+                    s->release_consumer();
+                }
+                return true;
+            }
+
+            bool is_cancelled() const noexcept {
+                return status_ == status::cancelled;
+            }
+        public:
+            bool add_consumer() noexcept {
+                std::lock_guard guard(mutex_);
+                if ( status_ != status::pending ) {
+                    return false;
+                }
+                ++consumers_;
+                orphaned_ = false;
+                return true;
+            }
+
+            // the last released consumer cancels the promise, raw subscribers
+            // are consumers too, so the cancellation waits for them to leave
+
+            void release_consumer() noexcept final {
+                if ( status_ != status::pending ) {
+                    return;
+                }
+                {
+                    std::lock_guard guard(mutex_);
+                    if ( !consumers_ || --consumers_ ) {
+                        return;
+                    }
+                    if ( subscribers_ ) {
+                        orphaned_ = true;
+                        return;
+                    }
+                }
+                cancel();
+            }
+
+            void set_upstream(std::weak_ptr<detail::cancellable_state> upstream) noexcept {
+                std::lock_guard guard(mutex_);
+                if ( status_ == status::pending ) {
+                    upstream_ = std::move(upstream);
+                }
+            }
+        public:
+            template < typename U, typename ResolveF, typename RejectF >
+            std::enable_if_t<std::is_void<U>::value, void>
+            attach(promise<U>& next, ResolveF&& on_resolve, RejectF&& on_reject, bool has_reject) {
+                auto reject_h = [
                     n = next,
                     f = std::forward<RejectF>(on_reject),
                     has_reject
@@ -1014,7 +2049,6 @@ namespace promise_hpp
                     }
                 };
 
-                std::lock_guard guard(mutex_);
                 add_handlers_(std::move(resolve_h), std::move(reject_h));
             }
 
@@ -1053,61 +2087,107 @@ namespace promise_hpp
                     }
                 };
 
-                std::lock_guard guard(mutex_);
                 add_handlers_(std::move(resolve_h), std::move(reject_h));
             }
+
+            template < typename ResolveF, typename RejectF >
+            detail::intrusive_list_hook* subscribe(ResolveF&& on_resolve, RejectF&& on_reject) {
+                return add_handlers_(
+                    std::forward<ResolveF>(on_resolve),
+                    std::forward<RejectF>(on_reject),
+                    true);
+            }
+
+            template < typename F >
+            detail::intrusive_list_hook* on_cancel(F&& f) {
+                return add_handlers_([](){
+                }, [this, f = std::forward<F>(f)](std::exception_ptr) mutable {
+                    if ( status_ == status::cancelled ) {
+                        std::invoke(f);
+                    }
+                });
+            }
+
+            bool unsubscribe(detail::intrusive_list_hook* handler) noexcept final {
+                if ( status_ != status::pending ) {
+                    return false;
+                }
+                {
+                    std::lock_guard guard(mutex_);
+                    if ( status_ != status::pending ) {
+                        return false;
+                    }
+                    handler_t* h = static_cast<handler_t*>(handler);
+                    const bool subscriber = h->subscriber_;
+                    handlers_.erase(h);
+                    if ( !subscriber || --subscribers_ || !orphaned_ ) {
+                        return true;
+                    }
+                }
+                cancel();
+                return true;
+            }
         private:
             template < typename ResolveF, typename RejectF >
-            void add_handlers_(ResolveF&& resolve, RejectF&& reject) {
+            detail::intrusive_list_hook* add_handlers_(
+                ResolveF&& resolve,
+                RejectF&& reject,
+                bool subscriber = false)
+            {
+                std::unique_lock lock(mutex_);
+                if ( status_ == status::pending ) {
+                    handler_t* handler = handlers_.push_back(std::make_unique<handler_t>(
+                        std::forward<ResolveF>(resolve),
+                        std::forward<RejectF>(reject)));
+                    if ( subscriber ) {
+                        handler->subscriber_ = true;
+                        ++subscribers_;
+                    }
+                    return handler;
+                }
+                lock.unlock();
                 if ( status_ == status::resolved ) {
                     std::invoke(
                         std::forward<ResolveF>(resolve));
-                } else if ( status_ == status::rejected ) {
+                } else {
                     std::invoke(
                         std::forward<RejectF>(reject),
                         exception_);
-                } else {
-                    handlers_.push_back({
-                        std::forward<ResolveF>(resolve),
-                        std::forward<RejectF>(reject)});
                 }
+                return nullptr;
             }
 
-            void invoke_resolve_handlers_() noexcept {
-                for ( const auto& h : handlers_ ) {
+            void invoke_resolve_handlers_(const handler_list& handlers) noexcept {
+                handlers.for_each([](const handler_t& h){
                     h.resolve_();
-                }
-                handlers_.clear();
+                });
             }
 
-            void invoke_reject_handlers_() noexcept {
-                for ( const auto& h : handlers_ ) {
+            void invoke_reject_handlers_(const handler_list& handlers) noexcept {
+                handlers.for_each([this](const handler_t& h){
                     h.reject_(exception_);
-                }
-                handlers_.clear();
+                });
             }
         private:
             enum class status {
                 pending,
                 resolved,
-                rejected
+                rejected,
+                cancelled
             };
 
-            status status_{status::pending};
+            std::atomic<status> status_{status::pending};
             std::exception_ptr exception_{nullptr};
 
+            std::size_t consumers_{0u};
+            std::size_t subscribers_{0u};
+            bool orphaned_{false};
+            std::weak_ptr<detail::cancellable_state> upstream_;
+
             mutable std::mutex mutex_;
             mutable std::condition_variable cond_var_;
 
-            struct handler {
-                using resolve_t = std::function<void()>;
-                using reject_t = std::function<void(std::exception_ptr)>;
-
-                resolve_t resolve_;
-                reject_t reject_;
-            };
-
-            std::vector<handler> handlers_;
+            handler_list handlers_;
         };
     };
 }
@@ -1195,57 +2275,353 @@ namespace promise_hpp
     // make_all_promise
     //
 
+    namespace impl
+    {
+        template < typename ResultType >
+        struct all_promise_result {
+            using type = std::vector<ResultType>;
+        };
+
+        template <>
+        struct all_promise_result<void> {
+            using type = void;
+        };
+
+        template < typename ResultType >
+        using all_promise_result_t = typename all_promise_result<ResultType>::type;
+
+        template < typename ResultType, typename = void >
+        struct all_promise_results_traits {
+            using results_t = std::vector<detail::storage<ResultType>>;
+
+            template < typename T >
+            static void apply(results_t& results, std::size_t index, T&& value) {
+                results[index] = std::forward<T>(value);
+            }
+
+            static std::vector<ResultType> extract(results_t& results) {
+                std::vector<ResultType> extracted;
+                extracted.reserve(results.size());
+                for ( auto&& r : results ) {
+                    extracted.push_back(std::move(*r));
+                }
+                return extracted;
+            }
+        };
+
+        template < typename ResultType >
+        struct all_promise_results_traits<ResultType, std::enable_if_t<
+            std::is_default_constructible_v<ResultType> &&
+            std::is_copy_assignable_v<ResultType> &&
+            !std::is_same_v<ResultType, bool>>>
+        {
+            using results_t = std::vector<ResultType>;
+
+            template < typename T >
+            static void apply(results_t& results, std::size_t index, T&& value) {
+                results[index] = std::forward<T>(value);
+            }
+
+            static std::vector<ResultType>&& extract(results_t& results) noexcept {
+                return std::move(results);
+            }
+        };
+
+        template < typename ResultType >
+        class all_promise_context_t final : private detail::noncopyable {
+        public:
+            using result_promise_t = promise<std::vector<ResultType>>;
+
+            all_promise_context_t(result_promise_t result, std::size_t count)
+            : result_(std::move(result))
+            , countdown_(count)
+            , results_(count) {}
+
+            template < typename T >
+            void apply_result(std::size_t index, T&& value) noexcept {
+                try {
+                    traits_t::apply(results_, index, std::forward<T>(value));
+                    if ( countdown_.count_down(index) ) {
+                        result_.resolve(traits_t::extract(results_));
+                    }
+                } catch (...) {
+                    result_.reject(std::current_exception());
+                }
+            }
+
+            void apply_exception(std::exception_ptr e) noexcept {
+                result_.reject(e);
+            }
+        private:
+            using traits_t = all_promise_results_traits<ResultType>;
+            result_promise_t result_;
+            detail::sharded_countdown countdown_;
+            typename traits_t::results_t results_;
+        };
+
+        template <>
+        class all_promise_context_t<void> final : private detail::noncopyable {
+        public:
+            using result_promise_t = promise<void>;
+
+            all_promise_context_t(result_promise_t result, std::size_t count)
+            : result_(std::move(result))
+            , countdown_(count) {}
+
+            void apply_result(std::size_t index) noexcept {
+                if ( countdown_.count_down(index) ) {
+                    result_.resolve();
+                }
+            }
+
+            void apply_exception(std::exception_ptr e) noexcept {
+                result_.reject(e);
+            }
+        private:
+            result_promise_t result_;
+            detail::sharded_countdown countdown_;
+        };
+    }
+
     template < typename Iter
              , typename SubPromise = typename std::iterator_traits<Iter>::value_type
              , typename SubPromiseResult = typename SubPromise::value_type
-             , typename ResultPromiseValueType = std::vector<SubPromiseResult> >
+             , typename ResultPromiseValueType = impl::all_promise_result_t<SubPromiseResult> >
     promise<ResultPromiseValueType>
     make_all_promise(Iter begin, Iter end) {
         if ( begin == end ) {
-            return make_resolved_promise(ResultPromiseValueType());
+            if constexpr ( std::is_void_v<ResultPromiseValueType> ) {
+                return make_resolved_promise();
+            } else {
+                return make_resolved_promise(ResultPromiseValueType());
+            }
         }
 
-        struct context_t {
-            std::atomic_size_t success_counter{0u};
-            std::vector<detail::storage<SubPromiseResult>> results;
-            context_t(std::size_t count)
-            : success_counter(count)
-            , results(count) {}
-        };
+        using context_t = impl::all_promise_context_t<SubPromiseResult>;
+
+        promise<ResultPromiseValueType> result;
 
-        return make_promise<ResultPromiseValueType>(
-        [begin, end](auto&& resolver, auto&& rejector){
+        try {
             std::size_t result_index = 0;
-            auto context = std::make_shared<context_t>(std::distance(begin, end));
+            auto context = std::make_shared<context_t>(
+                result,
+                static_cast<std::size_t>(std::distance(begin, end)));
             for ( Iter iter = begin; iter != end; ++iter, ++result_index ) {
-                (*iter).then([context, resolver, result_index](auto&& v) mutable {
-                    context->results[result_index] = std::forward<decltype(v)>(v);
-                    if ( !--context->success_counter ) {
-                        std::vector<SubPromiseResult> results;
-                        results.reserve(context->results.size());
-                        for ( auto&& r : context->results ) {
-                            results.push_back(std::move(*r));
+                if constexpr ( std::is_void_v<SubPromiseResult> ) {
+                    (*iter).subscribe([context, result_index](){
+                        context->apply_result(result_index);
+                    }, [context](std::exception_ptr e){
+                        context->apply_exception(e);
+                    });
+                } else {
+                    (*iter).subscribe([context, result_index](auto&& v){
+                        context->apply_result(result_index, std::forward<decltype(v)>(v));
+                    }, [context](std::exception_ptr e){
+                        context->apply_exception(e);
+                    });
+                }
+            }
+        } catch (...) {
+            result.reject(std::current_exception());
+        }
+
+        return result;
+    }
+
+    namespace impl
+    {
+        template < typename T >
+        struct is_promise_array
+        : std::false_type {};
+
+        template < typename T, std::size_t N >
+        struct is_promise_array<std::array<promise<T>, N>>
+        : std::true_type {};
+
+        template < typename T >
+        inline constexpr bool is_promise_array_v = is_promise_array<T>::value;
+
+        template < typename ResultType, std::size_t N >
+        class all_array_promise_context_t final : private detail::noncopyable {
+        public:
+            using result_promise_t = promise<std::array<ResultType, N>>;
+
+            explicit all_array_promise_context_t(result_promise_t result)
+            : result_(std::move(result)) {}
+
+            template < typename T >
+            void apply_result(std::size_t index, T&& value) noexcept {
+                try {
+                    results_[index] = std::forward<T>(value);
+                    if ( ++counter_ == N ) {
+                        result_.resolve(get_results_impl(
+                            std::make_index_sequence<N>()));
+                    }
+                } catch (...) {
+                    result_.reject(std::current_exception());
+                }
+            }
+
+            void apply_exception(std::exception_ptr e) noexcept {
+                result_.reject(e);
+            }
+        private:
+            template < std::size_t... Is >
+            std::array<ResultType, N> get_results_impl(std::index_sequence<Is...>) {
+                return {{std::move(*results_[Is])...}};
+            }
+        private:
+            result_promise_t result_;
+            std::atomic_size_t counter_{0u};
+            std::array<detail::storage<ResultType>, N> results_;
+        };
+
+        template < typename T
+                 , std::size_t N
+                 , typename ResultType = std::conditional_t<
+                    std::is_void_v<T>,
+                    void,
+                    std::array<T, N>> >
+        promise<ResultType> make_all_array_promise(const std::array<promise<T>, N>& promises) {
+            if constexpr ( N == 0 ) {
+                (void)promises;
+                if constexpr ( std::is_void_v<ResultType> ) {
+                    return make_resolved_promise();
+                } else {
+                    return make_resolved_promise(ResultType());
+                }
+            } else {
+                using context_t = std::conditional_t<
+                    std::is_void_v<ResultType>,
+                    all_promise_context_t<void>,
+                    all_array_promise_context_t<T, N>>;
+
+                promise<ResultType> result;
+
+                try {
+                    std::shared_ptr<context_t> context;
+                    if constexpr ( std::is_void_v<ResultType> ) {
+                        context = std::make_shared<context_t>(result, N);
+                    } else {
+                        context = std::make_shared<context_t>(result);
+                    }
+                    for ( std::size_t i = 0; i < N; ++i ) {
+                        promise<T> sub_promise = promises[i];
+                        if constexpr ( std::is_void_v<T> ) {
+                            sub_promise.subscribe([context, i](){
+                                context->apply_result(i);
+                            }, [context](std::exception_ptr e){
+                                context->apply_exception(e);
+                            });
+                        } else {
+                            sub_promise.subscribe([context, i](auto&& v){
+                                context->apply_result(i, std::forward<decltype(v)>(v));
+                            }, [context](std::exception_ptr e){
+                                context->apply_exception(e);
+                            });
                         }
-                        resolver(std::move(results));
                     }
-                }).except([rejector](std::exception_ptr e) mutable {
-                    rejector(e);
-                });
+                } catch (...) {
+                    result.reject(std::current_exception());
+                }
+
+                return result;
             }
-        });
+        }
     }
 
     template < typename Container >
     auto make_all_promise(Container&& container) {
-        return make_all_promise(
-            std::begin(container),
-            std::end(container));
+        if constexpr ( impl::is_promise_array_v<std::decay_t<Container>> ) {
+            return impl::make_all_array_promise(container);
+        } else {
+            return make_all_promise(
+                std::begin(container),
+                std::end(container));
+        }
     }
 
     //
     // make_any_promise
     //
 
+    namespace impl
+    {
+        class detachable_subscriptions_t final : private detail::noncopyable {
+        public:
+            explicit detachable_subscriptions_t(std::size_t count) {
+                subscriptions_.reserve(count);
+            }
+
+            void add(promise_subscription subscription) {
+                std::unique_lock lock(mutex_);
+                if ( !detached_ ) {
+                    subscriptions_.push_back(std::move(subscription));
+                    return;
+                }
+                lock.unlock();
+                subscription.unsubscribe();
+            }
+
+            void detach() noexcept {
+                std::vector<promise_subscription> subscriptions;
+                {
+                    std::lock_guard guard(mutex_);
+                    detached_ = true;
+                    subscriptions.swap(subscriptions_);
+                }
+                for ( promise_subscription& s : subscriptions ) {
+                    s.unsubscribe();
+                }
+            }
+        private:
+            std::mutex mutex_;
+            bool detached_{false};
+            std::vector<promise_subscription> subscriptions_;
+        };
+
+        template < typename ResultType >
+        class any_promise_context_t final : private detail::noncopyable {
+        public:
+            any_promise_context_t(promise<ResultType> result, std::size_t count)
+            : result_(std::move(result))
+            , failure_counter_(count)
+            , exceptions_(count)
+            , subscriptions_(count) {}
+
+            template < typename... Args >
+            void apply_result(Args&&... args) noexcept {
+                try {
+                    if ( result_.resolve(std::forward<Args>(args)...) ) {
+                        subscriptions_.detach();
+                    }
+                } catch (...) {
+                    result_.reject(std::current_exception());
+                }
+            }
+
+            void apply_exception(std::size_t index, std::exception_ptr e) noexcept {
+                exceptions_[index] = e;
+                if ( !--failure_counter_ ) {
+                    try {
+                        result_.reject(aggregate_exception(std::move(exceptions_)));
+                    } catch (...) {
+                        result_.reject(std::current_exception());
+                    }
+                }
+            }
+
+            void add_subscription(promise_subscription subscription) {
+                subscriptions_.add(std::move(subscription));
+            }
+        private:
+            promise<ResultType> result_;
+            std::atomic_size_t failure_counter_{0u};
+            std::vector<std::exception_ptr> exceptions_;
+            detachable_subscriptions_t subscriptions_;
+        };
+    }
+
     template < typename Iter
              , typename SubPromise = typename std::iterator_traits<Iter>::value_type
              , typename SubPromiseResult = typename SubPromise::value_type
@@ -1256,29 +2632,35 @@ namespace promise_hpp
             return make_rejected_promise<ResultPromiseValueType>(aggregate_exception());
         }
 
-        struct context_t {
-            std::atomic_size_t failure_counter{0u};
-            std::vector<std::exception_ptr> exceptions;
-            context_t(std::size_t count)
-            : failure_counter(count)
-            , exceptions(count) {}
-        };
+        using context_t = impl::any_promise_context_t<ResultPromiseValueType>;
 
-        return make_promise<ResultPromiseValueType>(
-        [begin, end](auto&& resolver, auto&& rejector){
+        promise<ResultPromiseValueType> result;
+
+        try {
             std::size_t exception_index = 0;
-            auto context = std::make_shared<context_t>(std::distance(begin, end));
+            auto context = std::make_shared<context_t>(
+                result,
+                static_cast<std::size_t>(std::distance(begin, end)));
             for ( Iter iter = begin; iter != end; ++iter, ++exception_index ) {
-                (*iter).then([resolver](auto&& v) mutable {
-                    resolver(std::forward<decltype(v)>(v));
-                }).except([context, rejector, exception_index](std::exception_ptr e) mutable {
-                    context->exceptions[exception_index] = e;
-                    if ( !--context->failure_counter ) {
-                        rejector(aggregate_exception(std::move(context->exceptions)));
-                    }
-                });
+                if constexpr ( std::is_void_v<SubPromiseResult> ) {
+                    context->add_subscription((*iter).subscribe([context](){
+                        context->apply_result();
+                    }, [context, exception_index](std::exception_ptr e){
+                        context->apply_exception(exception_index, e);
+                    }));
+                } else {
+                    context->add_subscription((*iter).subscribe([context](auto&& v){
+                        context->apply_result(std::forward<decltype(v)>(v));
+                    }, [context, exception_index](std::exception_ptr e){
+                        context->apply_exception(exception_index, e);
+                    }));
+                }
             }
-        });
+        } catch (...) {
+            result.reject(std::current_exception());
+        }
+
+        return result;
     }
 
     template < typename Container >
@@ -1292,20 +2674,75 @@ namespace promise_hpp
     // make_race_promise
     //
 
+    namespace impl
+    {
+        template < typename ResultType >
+        class race_promise_context_t final : private detail::noncopyable {
+        public:
+            race_promise_context_t(promise<ResultType> result, std::size_t count)
+            : result_(std::move(result))
+            , subscriptions_(count) {}
+
+            template < typename... Args >
+            void apply_result(Args&&... args) noexcept {
+                try {
+                    if ( result_.resolve(std::forward<Args>(args)...) ) {
+                        subscriptions_.detach();
+                    }
+                } catch (...) {
+                    apply_exception(std::current_exception());
+                }
+            }
+
+            void apply_exception(std::exception_ptr e) noexcept {
+                if ( result_.reject(e) ) {
+                    subscriptions_.detach();
+                }
+            }
+
+            void add_subscription(promise_subscription subscription) {
+                subscriptions_.add(std::move(subscription));
+            }
+        private:
+            promise<ResultType> result_;
+            detachable_subscriptions_t subscriptions_;
+        };
+    }
+
     template < typename Iter
              , typename SubPromise = typename std::iterator_traits<Iter>::value_type
              , typename SubPromiseResult = typename SubPromise::value_type
              , typename ResultPromiseValueType = SubPromiseResult >
     promise<ResultPromiseValueType>
     make_race_promise(Iter begin, Iter end) {
-        return make_promise<ResultPromiseValueType>(
-        [begin, end](auto&& resolver, auto&& rejector){
+        using context_t = impl::race_promise_context_t<ResultPromiseValueType>;
+
+        promise<ResultPromiseValueType> result;
+
+        try {
+            auto context = std::make_shared<context_t>(
+                result,
+                static_cast<std::size_t>(std::distance(begin, end)));
             for ( Iter iter = begin; iter != end; ++iter ) {
-                (*iter)
-                .then(resolver)
-                .except(rejector);
+                if constexpr ( std::is_void_v<SubPromiseResult> ) {
+                    context->add_subscription((*iter).subscribe([context](){
+                        context->apply_result();
+                    }, [context](std::exception_ptr e){
+                        context->apply_exception(e);
+                    }));
+                } else {
+                    context->add_subscription((*iter).subscribe([context](auto&& v){
+                        context->apply_result(std::forward<decltype(v)>(v));
+                    }, [context](std::exception_ptr e){
+                        context->apply_exception(e);
+                    }));
+                }
             }
-        });
+        } catch (...) {
+            result.reject(std::current_exception());
+        }
+
+        return result;
     }
 
     template < typename Container >
@@ -1316,111 +2753,1117 @@ namespace promise_hpp
     }
 
     //
-    // make_tuple_promise
+    // make_quorum_promise
     //
 
     namespace impl
     {
-        template < typename Tuple >
-        struct tuple_promise_result_impl {};
-
-        template < typename... Args >
-        struct tuple_promise_result_impl<std::tuple<promise<Args>...>> {
-            using type = std::tuple<Args...>;
-        };
-
-        template < typename Tuple >
-        struct tuple_promise_result {
-            using type = typename tuple_promise_result_impl<std::remove_cv_t<Tuple>>::type;
-        };
-
-        template < typename Tuple >
-        using tuple_promise_result_t = typename tuple_promise_result<Tuple>::type;
-
-        template < typename... ResultTypes >
-        class tuple_promise_context_t final : private detail::noncopyable {
+        template < typename ResultType >
+        class quorum_promise_context_t final : private detail::noncopyable {
         public:
-            template < std::size_t N, typename T >
-            bool apply_result(T&& value) {
-                std::get<N>(results_) = std::forward<T>(value);
-                return ++counter_ == sizeof...(ResultTypes);
+            using result_promise_t = promise<all_promise_result_t<ResultType>>;
+
+            quorum_promise_context_t(result_promise_t result, std::size_t count, std::size_t quorum)
+            : result_(std::move(result))
+            , quorum_(quorum)
+            , max_failures_(count - quorum + 1u)
+            , exceptions_(count)
+            , subscriptions_(count) {
+                if constexpr ( !std::is_void_v<ResultType> ) {
+                    results_.reserve(quorum);
+                }
             }
 
-            std::tuple<ResultTypes...> get_results() {
-                return get_results_impl(
-                    std::make_index_sequence<sizeof...(ResultTypes)>());
-            }
-        private:
-            template < std::size_t... Is >
-            std::tuple<ResultTypes...> get_results_impl(std::index_sequence<Is...>) {
-                return {std::move(*std::get<Is>(results_))...};
-            }
+            template < typename... Args >
+            void apply_result(Args&&... args) noexcept {
+                try {
+                    std::unique_lock lock(mutex_);
+                    if ( settled_ ) {
+                        return;
+                    }
+                    if constexpr ( !std::is_void_v<ResultType> ) {
+                        results_.emplace_back(std::forward<Args>(args)...);
+                    }
+                    if ( ++successes_ < quorum_ ) {
+                        return;
+                    }
+                    settled_ = true;
+                    lock.unlock();
+                    if constexpr ( std::is_void_v<ResultType> ) {
+                        result_.resolve();
+                    } else {
+                        result_.resolve(std::move(results_));
+                    }
+                } catch (...) {
+                    {
+                        std::lock_guard guard(mutex_);
+                        settled_ = true;
+                    }
+                    result_.reject(std::current_exception());
+                }
+                subscriptions_.detach();
+            }
+
+            void apply_exception(std::size_t index, std::exception_ptr e) noexcept {
+                {
+                    std::lock_guard guard(mutex_);
+                    if ( settled_ ) {
+                        return;
+                    }
+                    exceptions_[index] = e;
+                    if ( ++failures_ < max_failures_ ) {
+                        return;
+                    }
+                    settled_ = true;
+                }
+                try {
+                    result_.reject(aggregate_exception(std::move(exceptions_)));
+                } catch (...) {
+                    result_.reject(std::current_exception());
+                }
+                subscriptions_.detach();
+            }
+
+            void add_subscription(promise_subscription subscription) {
+                subscriptions_.add(std::move(subscription));
+            }
+        private:
+            using results_t = std::conditional_t<
+                std::is_void_v<ResultType>,
+                std::monostate,
+                all_promise_result_t<ResultType>>;
+
+            result_promise_t result_;
+            const std::size_t quorum_;
+            const std::size_t max_failures_;
+            std::mutex mutex_;
+            bool settled_{false};
+            std::size_t successes_{0u};
+            std::size_t failures_{0u};
+            results_t results_;
+            std::vector<std::exception_ptr> exceptions_;
+            detachable_subscriptions_t subscriptions_;
+        };
+    }
+
+    template < typename Iter
+             , typename SubPromise = typename std::iterator_traits<Iter>::value_type
+             , typename SubPromiseResult = typename SubPromise::value_type
+             , typename ResultPromiseValueType = impl::all_promise_result_t<SubPromiseResult> >
+    promise<ResultPromiseValueType>
+    make_quorum_promise(Iter begin, Iter end, std::size_t quorum) {
+        const auto count = static_cast<std::size_t>(std::distance(begin, end));
+
+        if ( !quorum ) {
+            if constexpr ( std::is_void_v<ResultPromiseValueType> ) {
+                return make_resolved_promise();
+            } else {
+                return make_resolved_promise(ResultPromiseValueType());
+            }
+        }
+
+        if ( quorum > count ) {
+            return make_rejected_promise<ResultPromiseValueType>(aggregate_exception());
+        }
+
+        using context_t = impl::quorum_promise_context_t<SubPromiseResult>;
+
+        promise<ResultPromiseValueType> result;
+
+        try {
+            std::size_t exception_index = 0;
+            auto context = std::make_shared<context_t>(result, count, quorum);
+            for ( Iter iter = begin; iter != end; ++iter, ++exception_index ) {
+                if constexpr ( std::is_void_v<SubPromiseResult> ) {
+                    context->add_subscription((*iter).subscribe([context](){
+                        context->apply_result();
+                    }, [context, exception_index](std::exception_ptr e){
+                        context->apply_exception(exception_index, e);
+                    }));
+                } else {
+                    context->add_subscription((*iter).subscribe([context](auto&& v){
+                        context->apply_result(std::forward<decltype(v)>(v));
+                    }, [context, exception_index](std::exception_ptr e){
+                        context->apply_exception(exception_index, e);
+                    }));
+                }
+            }
+        } catch (...) {
+            result.reject(std::current_exception());
+        }
+
+        return result;
+    }
+
+    template < typename Container >
+    auto make_quorum_promise(Container&& container, std::size_t quorum) {
+        return make_quorum_promise(
+            std::begin(container),
+            std::end(container),
+            quorum);
+    }
+
+    //
+    // when_all
+    //
+
+    namespace impl
+    {
+        template < typename Tuple >
+        struct tuple_promise_result_impl {};
+
+        template < typename... Args >
+        struct tuple_promise_result_impl<std::tuple<promise<Args>...>> {
+            using type = std::conditional_t<
+                sizeof...(Args) != 0 && std::conjunction_v<std::is_void<Args>...>,
+                void,
+                std::tuple<Args...>>;
+        };
+
+        template < typename Tuple >
+        struct tuple_promise_result {
+            using type = typename tuple_promise_result_impl<std::remove_cv_t<Tuple>>::type;
+        };
+
+        template < typename Tuple >
+        using tuple_promise_result_t = typename tuple_promise_result<Tuple>::type;
+
+        template < typename... ResultTypes >
+        class tuple_promise_context_t final : private detail::noncopyable {
+        public:
+            using result_promise_t = promise<std::tuple<ResultTypes...>>;
+
+            explicit tuple_promise_context_t(result_promise_t result)
+            : result_(std::move(result)) {}
+
+            template < std::size_t N, typename T >
+            void apply_result(T&& value) noexcept {
+                try {
+                    std::get<N>(results_) = std::forward<T>(value);
+                    if ( ++counter_ == sizeof...(ResultTypes) ) {
+                        result_.resolve(get_results_impl(
+                            std::make_index_sequence<sizeof...(ResultTypes)>()));
+                    }
+                } catch (...) {
+                    result_.reject(std::current_exception());
+                }
+            }
+
+            void apply_exception(std::exception_ptr e) noexcept {
+                result_.reject(e);
+            }
         private:
+            template < std::size_t... Is >
+            std::tuple<ResultTypes...> get_results_impl(std::index_sequence<Is...>) {
+                return {std::move(*std::get<Is>(results_))...};
+            }
+        private:
+            result_promise_t result_;
             std::atomic_size_t counter_{0};
             std::tuple<detail::storage<ResultTypes>...> results_;
         };
 
-        template < typename... ResultTypes >
-        using tuple_promise_context_ptr = std::shared_ptr<
-            tuple_promise_context_t<ResultTypes...>>;
-
-        template < std::size_t I
-                 , typename Tuple
-                 , typename Resolver
-                 , typename Rejector
-                 , typename... ResultTypes >
-        promise<void> make_tuple_sub_promise_impl(
-            Tuple&& tuple,
-            Resolver&& resolver,
-            Rejector&& rejector,
-            const tuple_promise_context_ptr<ResultTypes...>& context)
+        template < typename Context, typename... Args, std::size_t... Is >
+        void subscribe_when_all_impl(
+            const std::shared_ptr<Context>& context,
+            std::index_sequence<Is...>,
+            promise<Args>&... promises)
         {
-            return std::get<I>(tuple).then([
-                context,
-                resolver
-            ](auto&& v) mutable {
-                if (context->template apply_result<I>(std::forward<decltype(v)>(v))) {
-                    resolver(context->get_results());
+            if constexpr ( std::conjunction_v<std::is_void<Args>...> ) {
+                (promises.subscribe([context](){
+                    context->apply_result(Is);
+                }, [context](std::exception_ptr e){
+                    context->apply_exception(e);
+                }), ...);
+            } else {
+                (promises.subscribe([context](auto&& v){
+                    context->template apply_result<Is>(std::forward<decltype(v)>(v));
+                }, [context](std::exception_ptr e){
+                    context->apply_exception(e);
+                }), ...);
+            }
+        }
+    }
+
+    template < typename... Args
+             , typename ResultType = impl::tuple_promise_result_t<std::tuple<promise<Args>...>> >
+    promise<ResultType> when_all(promise<Args>... promises) {
+        if constexpr ( sizeof...(Args) == 0 ) {
+            return make_resolved_promise(ResultType());
+        } else {
+            using context_t = std::conditional_t<
+                std::is_void_v<ResultType>,
+                impl::all_promise_context_t<void>,
+                impl::tuple_promise_context_t<Args...>>;
+
+            promise<ResultType> result;
+
+            try {
+                std::shared_ptr<context_t> context;
+                if constexpr ( std::is_void_v<ResultType> ) {
+                    context = std::make_shared<context_t>(result, sizeof...(Args));
+                } else {
+                    context = std::make_shared<context_t>(result);
                 }
-            }).except(rejector);
+                impl::subscribe_when_all_impl(
+                    context,
+                    std::index_sequence_for<Args...>(),
+                    promises...);
+            } catch (...) {
+                result.reject(std::current_exception());
+            }
+
+            return result;
         }
+    }
 
-        template < typename Tuple
-                 , std::size_t... Is
-                 , typename ResultTuple = tuple_promise_result_t<std::decay_t<Tuple>> >
-        std::enable_if_t<
-            sizeof...(Is) == 0,
-            promise<ResultTuple>>
-        make_tuple_promise_impl(Tuple&&, std::index_sequence<Is...>) {
-            return make_resolved_promise(ResultTuple());
+    //
+    // make_tuple_promise
+    //
+
+    template < typename Tuple
+             , typename ResultTuple = impl::tuple_promise_result_t<std::decay_t<Tuple>> >
+    promise<ResultTuple>
+    make_tuple_promise(Tuple&& tuple) {
+        return std::apply([](auto&... promises){
+            return when_all(promises...);
+        }, tuple);
+    }
+}
+
+namespace promise_hpp
+{
+    //
+    // make_all_settled_promise
+    //
+
+    namespace impl
+    {
+        template < typename ResultType >
+        class all_settled_promise_context_t final : private detail::noncopyable {
+        public:
+            using results_t = std::vector<settled_result<ResultType>>;
+            using result_promise_t = promise<results_t>;
+
+            all_settled_promise_context_t(result_promise_t result, std::size_t count)
+            : result_(std::move(result))
+            , countdown_(count)
+            , results_(count) {}
+
+            template < typename... Args >
+            void apply_result(std::size_t index, Args&&... args) noexcept {
+                try {
+                    results_[index] = settled_result<ResultType>(std::forward<Args>(args)...);
+                } catch (...) {
+                    results_[index] = settled_result<ResultType>(std::current_exception());
+                }
+                if ( countdown_.count_down(index) ) {
+                    result_.resolve(std::move(results_));
+                }
+            }
+        private:
+            result_promise_t result_;
+            detail::sharded_countdown countdown_;
+            results_t results_;
+        };
+    }
+
+    template < typename Iter
+             , typename SubPromise = typename std::iterator_traits<Iter>::value_type
+             , typename SubPromiseResult = typename SubPromise::value_type
+             , typename ResultPromiseValueType = std::vector<settled_result<SubPromiseResult>> >
+    promise<ResultPromiseValueType>
+    make_all_settled_promise(Iter begin, Iter end) {
+        if ( begin == end ) {
+            return make_resolved_promise(ResultPromiseValueType());
+        }
+
+        using context_t = impl::all_settled_promise_context_t<SubPromiseResult>;
+
+        promise<ResultPromiseValueType> result;
+
+        try {
+            std::size_t result_index = 0;
+            auto context = std::make_shared<context_t>(
+                result,
+                static_cast<std::size_t>(std::distance(begin, end)));
+            for ( Iter iter = begin; iter != end; ++iter, ++result_index ) {
+                if constexpr ( std::is_void_v<SubPromiseResult> ) {
+                    (*iter).subscribe([context, result_index](){
+                        context->apply_result(result_index, std::in_place);
+                    }, [context, result_index](std::exception_ptr e){
+                        context->apply_result(result_index, e);
+                    });
+                } else {
+                    (*iter).subscribe([context, result_index](auto&& v){
+                        context->apply_result(result_index, std::forward<decltype(v)>(v));
+                    }, [context, result_index](std::exception_ptr e){
+                        context->apply_result(result_index, e);
+                    });
+                }
+            }
+        } catch (...) {
+            result.reject(std::current_exception());
+        }
+
+        return result;
+    }
+
+    template < typename Container >
+    auto make_all_settled_promise(Container&& container) {
+        return make_all_settled_promise(
+            std::begin(container),
+            std::end(container));
+    }
+
+    //
+    // for_each_as_completed
+    //
+
+    namespace impl
+    {
+        template < typename ResultType >
+        promise_subscription subscribe_as_completed_impl(
+            promise<ResultType>& sub_promise,
+            std::size_t index,
+            const std::function<void(std::size_t, settled_result<ResultType>)>& apply)
+        {
+            if constexpr ( std::is_void_v<ResultType> ) {
+                return sub_promise.subscribe([apply, index](){
+                    apply(index, settled_result<ResultType>(std::in_place));
+                }, [apply, index](std::exception_ptr e){
+                    apply(index, settled_result<ResultType>(e));
+                });
+            } else {
+                return sub_promise.subscribe([apply, index](auto&& v){
+                    try {
+                        apply(index, settled_result<ResultType>(std::forward<decltype(v)>(v)));
+                    } catch (...) {
+                        apply(index, settled_result<ResultType>(std::current_exception()));
+                    }
+                }, [apply, index](std::exception_ptr e){
+                    apply(index, settled_result<ResultType>(e));
+                });
+            }
+        }
+
+        template < typename ResultType, typename F >
+        class for_each_as_completed_context_t final : private detail::noncopyable {
+        public:
+            template < typename U >
+            for_each_as_completed_context_t(promise<void> result, std::size_t count, U&& f)
+            : result_(std::move(result))
+            , count_(count)
+            , f_(std::forward<U>(f))
+            , subscriptions_(count) {}
+
+            // completions are queued and delivered one at a time by the
+            // thread that found the queue idle, so 'f' is never reentered
+
+            void apply_result(std::size_t index, settled_result<ResultType> r) noexcept {
+                std::unique_lock lock(mutex_);
+                if ( stopped_ ) {
+                    return;
+                }
+                try {
+                    ready_.emplace_back(index, std::move(r));
+                } catch (...) {
+                    lock.unlock();
+                    apply_exception(std::current_exception());
+                    return;
+                }
+                if ( delivering_ ) {
+                    return;
+                }
+                delivering_ = true;
+                while ( !ready_.empty() && !stopped_ ) {
+                    auto item = std::move(ready_.front());
+                    ready_.pop_front();
+                    lock.unlock();
+                    if ( result_.is_cancelled() ) {
+                        apply_cancel();
+                        return;
+                    }
+                    try {
+                        std::invoke(f_, item.first, std::move(item.second));
+                    } catch (...) {
+                        apply_exception(std::current_exception());
+                        return;
+                    }
+                    lock.lock();
+                    if ( ++delivered_ == count_ ) {
+                        lock.unlock();
+                        result_.resolve();
+                        return;
+                    }
+                }
+                delivering_ = false;
+            }
+
+            void apply_exception(std::exception_ptr e) noexcept {
+                stop_();
+                result_.reject(e);
+            }
+
+            void apply_cancel() noexcept {
+                stop_();
+            }
+
+            void add_subscription(promise_subscription subscription) {
+                subscriptions_.add(std::move(subscription));
+            }
+        private:
+            // drops the queued completions and the subscriptions to
+            // the inputs that have not settled yet
+
+            void stop_() noexcept {
+                std::deque<std::pair<std::size_t, settled_result<ResultType>>> ready;
+                {
+                    std::lock_guard guard(mutex_);
+                    stopped_ = true;
+                    ready.swap(ready_);
+                }
+                subscriptions_.detach();
+            }
+        private:
+            promise<void> result_;
+            const std::size_t count_;
+            F f_;
+            std::mutex mutex_;
+            bool stopped_{false};
+            bool delivering_{false};
+            std::size_t delivered_{0u};
+            std::deque<std::pair<std::size_t, settled_result<ResultType>>> ready_;
+            detachable_subscriptions_t subscriptions_;
+        };
+    }
+
+    template < typename Iter, typename F
+             , typename SubPromise = typename std::iterator_traits<Iter>::value_type
+             , typename SubPromiseResult = typename SubPromise::value_type >
+    promise<void> for_each_as_completed(Iter begin, Iter end, F&& f) {
+        if ( begin == end ) {
+            return make_resolved_promise();
+        }
+
+        using context_t = impl::for_each_as_completed_context_t<
+            SubPromiseResult,
+            std::decay_t<F>>;
+
+        promise<void> result;
+
+        try {
+            std::size_t result_index = 0;
+            auto context = std::make_shared<context_t>(
+                result,
+                static_cast<std::size_t>(std::distance(begin, end)),
+                std::forward<F>(f));
+            result.on_cancel([weak_context = std::weak_ptr<context_t>(context)](){
+                if ( auto context = weak_context.lock() ) {
+                    context->apply_cancel();
+                }
+            });
+            const std::function<void(std::size_t, settled_result<SubPromiseResult>)> apply =
+                [context](std::size_t index, settled_result<SubPromiseResult> r){
+                    context->apply_result(index, std::move(r));
+                };
+            for ( Iter iter = begin; iter != end; ++iter, ++result_index ) {
+                context->add_subscription(
+                    impl::subscribe_as_completed_impl(*iter, result_index, apply));
+            }
+        } catch (...) {
+            result.reject(std::current_exception());
+        }
+
+        return result;
+    }
+
+    template < typename Container, typename F >
+    promise<void> for_each_as_completed(Container&& container, F&& f) {
+        return for_each_as_completed(
+            std::begin(container),
+            std::end(container),
+            std::forward<F>(f));
+    }
+
+    //
+    // as_completed
+    //
+
+    namespace impl
+    {
+        template < typename ResultType >
+        class as_completed_state_t final : private detail::noncopyable {
+        public:
+            using completion_t = std::pair<std::size_t, settled_result<ResultType>>;
+
+            // every input settles once, so 'ready_' never grows past
+            // 'count_' and 'apply_result' does not allocate
+
+            explicit as_completed_state_t(std::size_t count)
+            : count_(count)
+            , remaining_(count) {
+                ready_.reserve(count);
+            }
+
+            void apply_result(std::size_t index, settled_result<ResultType> r) noexcept {
+                std::unique_lock lock(mutex_);
+                if ( waiters_.empty() ) {
+                    try {
+                        ready_.emplace_back(index, std::move(r));
+                    } catch (...) {
+                        ready_.emplace_back(index, settled_result<ResultType>(std::current_exception()));
+                    }
+                    return;
+                }
+                promise<completion_t> waiter = std::move(waiters_.front());
+                waiters_.pop_front();
+                lock.unlock();
+                try {
+                    waiter.resolve(completion_t(index, std::move(r)));
+                } catch (...) {
+                    waiter.reject(std::current_exception());
+                }
+            }
+
+            promise<completion_t> next() {
+                std::lock_guard guard(mutex_);
+                if ( !remaining_ ) {
+                    return make_rejected_promise<completion_t>(
+                        std::out_of_range("as_completed queue is exhausted"));
+                }
+                if ( ready_head_ == ready_.size() ) {
+                    waiters_.emplace_back();
+                    --remaining_;
+                    return waiters_.back();
+                }
+                completion_t completion = std::move(ready_[ready_head_++]);
+                --remaining_;
+                return make_resolved_promise(std::move(completion));
+            }
+
+            std::size_t size() const noexcept {
+                return count_;
+            }
+
+            std::size_t remaining() const noexcept {
+                std::lock_guard guard(mutex_);
+                return remaining_;
+            }
+        private:
+            const std::size_t count_;
+            std::size_t remaining_{0u};
+            mutable std::mutex mutex_;
+            std::size_t ready_head_{0u};
+            std::vector<completion_t> ready_;
+            std::deque<promise<completion_t>> waiters_;
+        };
+    }
+
+    template < typename T >
+    class as_completed_queue final {
+    public:
+        using completion_type = std::pair<std::size_t, settled_result<T>>;
+        using state_ptr = std::shared_ptr<impl::as_completed_state_t<T>>;
+
+        explicit as_completed_queue(state_ptr state) noexcept
+        : state_(std::move(state)) {}
+
+        // every pulled promise is resolved with the index and the outcome
+        // of the next settled input, once all inputs are pulled the queue
+        // hands out promises rejected with std::out_of_range
+
+        promise<completion_type> next() {
+            return state_->next();
+        }
+
+        bool empty() const noexcept {
+            return !remaining();
+        }
+
+        std::size_t size() const noexcept {
+            return state_->size();
+        }
+
+        std::size_t remaining() const noexcept {
+            return state_->remaining();
+        }
+    private:
+        state_ptr state_;
+    };
+
+    template < typename Iter
+             , typename SubPromise = typename std::iterator_traits<Iter>::value_type
+             , typename SubPromiseResult = typename SubPromise::value_type >
+    as_completed_queue<SubPromiseResult> as_completed(Iter begin, Iter end) {
+        using state_t = impl::as_completed_state_t<SubPromiseResult>;
+
+        std::size_t result_index = 0;
+        auto state = std::make_shared<state_t>(
+            static_cast<std::size_t>(std::distance(begin, end)));
+        const std::function<void(std::size_t, settled_result<SubPromiseResult>)> apply =
+            [state](std::size_t index, settled_result<SubPromiseResult> r){
+                state->apply_result(index, std::move(r));
+            };
+        for ( Iter iter = begin; iter != end; ++iter, ++result_index ) {
+            impl::subscribe_as_completed_impl(*iter, result_index, apply);
+        }
+
+        return as_completed_queue<SubPromiseResult>(std::move(state));
+    }
+
+    template < typename Container >
+    auto as_completed(Container&& container) {
+        return as_completed(
+            std::begin(container),
+            std::end(container));
+    }
+
+    //
+    // make_tuple_settled_promise
+    //
+
+    namespace impl
+    {
+        template < typename Tuple >
+        struct tuple_settled_promise_result_impl {};
+
+        template < typename... Args >
+        struct tuple_settled_promise_result_impl<std::tuple<promise<Args>...>> {
+            using type = std::tuple<settled_result<Args>...>;
+        };
+
+        template < typename Tuple >
+        struct tuple_settled_promise_result {
+            using type = typename tuple_settled_promise_result_impl<std::remove_cv_t<Tuple>>::type;
+        };
+
+        template < typename Tuple >
+        using tuple_settled_promise_result_t = typename tuple_settled_promise_result<Tuple>::type;
+
+        template < typename ResultTuple >
+        class tuple_settled_promise_context_t final : private detail::noncopyable {
+        public:
+            explicit tuple_settled_promise_context_t(promise<ResultTuple> result)
+            : result_(std::move(result)) {}
+
+            template < std::size_t N, typename... Args >
+            void apply_result(Args&&... args) noexcept {
+                using result_t = std::tuple_element_t<N, ResultTuple>;
+                try {
+                    std::get<N>(results_) = result_t(std::forward<Args>(args)...);
+                } catch (...) {
+                    std::get<N>(results_) = result_t(std::current_exception());
+                }
+                if ( ++counter_ == std::tuple_size_v<ResultTuple> ) {
+                    result_.resolve(std::move(results_));
+                }
+            }
+        private:
+            promise<ResultTuple> result_;
+            std::atomic_size_t counter_{0u};
+            ResultTuple results_;
+        };
+
+        template < std::size_t I, typename Tuple, typename Context >
+        void subscribe_tuple_settled_impl(Tuple& tuple, const std::shared_ptr<Context>& context) {
+            auto& sub_promise = std::get<I>(tuple);
+            using sub_promise_t = std::decay_t<decltype(sub_promise)>;
+            if constexpr ( std::is_void_v<typename sub_promise_t::value_type> ) {
+                sub_promise.subscribe([context](){
+                    context->template apply_result<I>(std::in_place);
+                }, [context](std::exception_ptr e){
+                    context->template apply_result<I>(e);
+                });
+            } else {
+                sub_promise.subscribe([context](auto&& v){
+                    context->template apply_result<I>(std::forward<decltype(v)>(v));
+                }, [context](std::exception_ptr e){
+                    context->template apply_result<I>(e);
+                });
+            }
         }
 
         template < typename Tuple
                  , std::size_t... Is
-                 , typename ResultTuple = tuple_promise_result_t<std::decay_t<Tuple>> >
-        std::enable_if_t<
-            sizeof...(Is) != 0,
-            promise<ResultTuple>>
-        make_tuple_promise_impl(Tuple&& tuple, std::index_sequence<Is...>) {
-            auto result = promise<ResultTuple>();
+                 , typename ResultTuple = tuple_settled_promise_result_t<std::decay_t<Tuple>> >
+        promise<ResultTuple> make_tuple_settled_promise_impl(Tuple& tuple, std::index_sequence<Is...>) {
+            if constexpr ( sizeof...(Is) == 0 ) {
+                (void)tuple;
+                return make_resolved_promise(ResultTuple());
+            } else {
+                promise<ResultTuple> result;
+                try {
+                    auto context = std::make_shared<
+                        tuple_settled_promise_context_t<ResultTuple>>(result);
+                    (subscribe_tuple_settled_impl<Is>(tuple, context), ...);
+                } catch (...) {
+                    result.reject(std::current_exception());
+                }
+                return result;
+            }
+        }
+    }
 
-            auto resolver = [result](auto&& v) mutable {
-                return result.resolve(std::forward<decltype(v)>(v));
-            };
+    template < typename Tuple
+             , typename ResultTuple = impl::tuple_settled_promise_result_t<std::decay_t<Tuple>> >
+    promise<ResultTuple>
+    make_tuple_settled_promise(Tuple&& tuple) {
+        return impl::make_tuple_settled_promise_impl(
+            tuple,
+            std::make_index_sequence<std::tuple_size_v<std::decay_t<Tuple>>>());
+    }
 
-            auto rejector = [result](auto&& e) mutable {
-                return result.reject(std::forward<decltype(e)>(e));
-            };
+    //
+    // promise_while
+    //
+
+    namespace impl
+    {
+        template < typename Cond, typename Body >
+        class while_promise_context_t final
+            : private detail::noncopyable
+            , public std::enable_shared_from_this<while_promise_context_t<Cond, Body>> {
+        public:
+            template < typename C, typename B >
+            while_promise_context_t(promise<void> result, C&& cond, B&& body)
+            : result_(std::move(result))
+            , cond_(std::forward<C>(cond))
+            , body_(std::forward<B>(body)) {}
+
+            // iterations settled synchronously are continued by this loop,
+            // the last of the loop and the handler to arrive continues it
+
+            void run() noexcept {
+                try {
+                    const auto self = this->shared_from_this();
+                    while ( !result_.is_cancelled() && std::invoke(cond_) ) {
+                        next_step_.store(false);
+                        std::invoke(body_).subscribe([self](auto&&...){
+                            if ( self->next_step_.exchange(true) ) {
+                                self->run();
+                            }
+                        }, [self](std::exception_ptr e){
+                            self->result_.reject(e);
+                        });
+                        if ( !next_step_.exchange(true) ) {
+                            return;
+                        }
+                    }
+                    result_.resolve();
+                } catch (...) {
+                    result_.reject(std::current_exception());
+                }
+            }
+        private:
+            promise<void> result_;
+            Cond cond_;
+            Body body_;
+            std::atomic<bool> next_step_{false};
+        };
+    }
+
+    template < typename Cond, typename Body >
+    promise<void> promise_while(Cond&& cond, Body&& body) {
+        static_assert(
+            is_promise<std::invoke_result_t<std::decay_t<Body>>>::value,
+            "loop body must return a promise");
+
+        using context_t = impl::while_promise_context_t<
+            std::decay_t<Cond>,
+            std::decay_t<Body>>;
+
+        promise<void> result;
+
+        try {
+            std::make_shared<context_t>(
+                result,
+                std::forward<Cond>(cond),
+                std::forward<Body>(body))->run();
+        } catch (...) {
+            result.reject(std::current_exception());
+        }
+
+        return result;
+    }
+
+    //
+    // repeat_until
+    //
+
+    namespace impl
+    {
+        template < typename ResultType, typename Body, typename Pred >
+        class repeat_promise_context_t final
+            : private detail::noncopyable
+            , public std::enable_shared_from_this<repeat_promise_context_t<ResultType, Body, Pred>> {
+        public:
+            template < typename B, typename P >
+            repeat_promise_context_t(promise<ResultType> result, B&& body, P&& pred)
+            : result_(std::move(result))
+            , body_(std::forward<B>(body))
+            , pred_(std::forward<P>(pred)) {}
+
+            void run() noexcept {
+                try {
+                    const auto self = this->shared_from_this();
+                    while ( !result_.is_cancelled() ) {
+                        next_step_.store(false);
+                        if constexpr ( std::is_void_v<ResultType> ) {
+                            std::invoke(body_).subscribe([self](){
+                                self->apply_result();
+                            }, [self](std::exception_ptr e){
+                                self->result_.reject(e);
+                            });
+                        } else {
+                            std::invoke(body_).subscribe([self](auto&& v){
+                                self->apply_result(std::forward<decltype(v)>(v));
+                            }, [self](std::exception_ptr e){
+                                self->result_.reject(e);
+                            });
+                        }
+                        if ( !next_step_.exchange(true) ) {
+                            return;
+                        }
+                    }
+                } catch (...) {
+                    result_.reject(std::current_exception());
+                }
+            }
+        private:
+            template < typename... Args >
+            void apply_result(Args&&... args) noexcept {
+                try {
+                    if ( std::invoke(pred_, std::as_const(args)...) ) {
+                        result_.resolve(std::forward<Args>(args)...);
+                        return;
+                    }
+                } catch (...) {
+                    result_.reject(std::current_exception());
+                    return;
+                }
+                if ( next_step_.exchange(true) ) {
+                    run();
+                }
+            }
+        private:
+            promise<ResultType> result_;
+            Body body_;
+            Pred pred_;
+            std::atomic<bool> next_step_{false};
+        };
+    }
+
+    template < typename Body, typename Pred
+             , typename R = typename std::invoke_result_t<std::decay_t<Body>>::value_type >
+    promise<R> repeat_until(Body&& body, Pred&& pred) {
+        static_assert(
+            is_promise_r<R, std::invoke_result_t<std::decay_t<Body>>>::value,
+            "loop body must return a promise");
+
+        using context_t = impl::repeat_promise_context_t<
+            R,
+            std::decay_t<Body>,
+            std::decay_t<Pred>>;
+
+        promise<R> result;
+
+        try {
+            std::make_shared<context_t>(
+                result,
+                std::forward<Body>(body),
+                std::forward<Pred>(pred))->run();
+        } catch (...) {
+            result.reject(std::current_exception());
+        }
+
+        return result;
+    }
+
+    //
+    // map_concurrent
+    //
+
+    namespace impl
+    {
+        template < typename Iter, typename F >
+        using map_promise_value_t = typename std::invoke_result_t<
+            F&,
+            typename std::iterator_traits<Iter>::reference>::value_type;
+
+        template < typename Iter, typename F >
+        class map_promise_context_t final
+            : private detail::noncopyable
+            , public std::enable_shared_from_this<map_promise_context_t<Iter, F>> {
+        public:
+            using value_type = map_promise_value_t<Iter, F>;
+            using result_promise_t = promise<all_promise_result_t<value_type>>;
+
+            template < typename U >
+            map_promise_context_t(
+                result_promise_t result,
+                Iter begin,
+                Iter end,
+                std::size_t max_in_flight,
+                U&& fn,
+                std::shared_ptr<void> inputs = nullptr)
+            : result_(std::move(result))
+            , next_(begin)
+            , end_(end)
+            , count_(static_cast<std::size_t>(std::distance(begin, end)))
+            , max_in_flight_(std::max(max_in_flight, std::size_t{1u}))
+            , fn_(std::forward<U>(fn))
+            , inputs_(std::move(inputs))
+            , results_(make_results_(count_)) {}
+
+            // only one thread launches operations at a time, settled
+            // operations started by it are picked up by its loop
+
+            void run() noexcept {
+                {
+                    std::lock_guard guard(mutex_);
+                    if ( launching_ ) {
+                        return;
+                    }
+                    launching_ = true;
+                }
+                while ( true ) {
+                    Iter iter;
+                    std::size_t index = 0;
+                    {
+                        std::lock_guard guard(mutex_);
+                        if ( settled_ || next_ == end_ || in_flight_ >= max_in_flight_ ) {
+                            launching_ = false;
+                            return;
+                        }
+                        iter = next_++;
+                        index = next_index_++;
+                        ++in_flight_;
+                    }
+                    launch_(iter, index);
+                }
+            }
+        private:
+            void launch_(Iter iter, std::size_t index) noexcept {
+                try {
+                    const auto self = this->shared_from_this();
+                    if constexpr ( std::is_void_v<value_type> ) {
+                        std::invoke(fn_, *iter).subscribe([self](){
+                            self->apply_result(0u);
+                        }, [self](std::exception_ptr e){
+                            self->apply_exception(e);
+                        });
+                    } else {
+                        std::invoke(fn_, *iter).subscribe([self, index](auto&& v){
+                            self->apply_result(index, std::forward<decltype(v)>(v));
+                        }, [self](std::exception_ptr e){
+                            self->apply_exception(e);
+                        });
+                    }
+                } catch (...) {
+                    apply_exception(std::current_exception());
+                }
+            }
+
+            template < typename... Args >
+            void apply_result(std::size_t index, Args&&... args) noexcept {
+                try {
+                    if constexpr ( !std::is_void_v<value_type> ) {
+                        traits_t::apply(results_, index, std::forward<Args>(args)...);
+                    }
+                    bool completed = false;
+                    {
+                        std::lock_guard guard(mutex_);
+                        --in_flight_;
+                        completed = ++completed_ == count_;
+                    }
+                    if ( !completed ) {
+                        run();
+                    } else if constexpr ( std::is_void_v<value_type> ) {
+                        result_.resolve();
+                    } else {
+                        result_.resolve(traits_t::extract(results_));
+                    }
+                } catch (...) {
+                    apply_exception(std::current_exception());
+                }
+            }
+
+            void apply_exception(std::exception_ptr e) noexcept {
+                {
+                    std::lock_guard guard(mutex_);
+                    settled_ = true;
+                }
+                result_.reject(e);
+            }
+        private:
+            using traits_t = all_promise_results_traits<
+                std::conditional_t<std::is_void_v<value_type>, int, value_type>>;
+            using results_t = std::conditional_t<
+                std::is_void_v<value_type>,
+                std::monostate,
+                typename traits_t::results_t>;
+
+            static results_t make_results_(std::size_t count) {
+                if constexpr ( std::is_void_v<value_type> ) {
+                    return results_t();
+                } else {
+                    return results_t(count);
+                }
+            }
+
+            result_promise_t result_;
+            Iter next_;
+            const Iter end_;
+            const std::size_t count_;
+            const std::size_t max_in_flight_;
+            F fn_;
+            std::shared_ptr<void> inputs_;
+            std::mutex mutex_;
+            bool settled_{false};
+            bool launching_{false};
+            std::size_t next_index_{0u};
+            std::size_t in_flight_{0u};
+            std::size_t completed_{0u};
+            results_t results_;
+        };
+
+        template < typename Iter, typename F >
+        auto make_map_promise(
+            Iter begin,
+            Iter end,
+            std::size_t max_in_flight,
+            F&& fn,
+            std::shared_ptr<void> inputs = nullptr)
+        {
+            using context_t = map_promise_context_t<Iter, std::decay_t<F>>;
+            using result_promise_t = typename context_t::result_promise_t;
+
+            static_assert(
+                is_promise<std::invoke_result_t<
+                    std::decay_t<F>&,
+                    typename std::iterator_traits<Iter>::reference>>::value,
+                "map function must return a promise");
+
+            result_promise_t result;
+
+            if ( begin == end ) {
+                if constexpr ( std::is_void_v<typename context_t::value_type> ) {
+                    result.resolve();
+                } else {
+                    result.resolve(typename result_promise_t::value_type());
+                }
+                return result;
+            }
 
             try {
-                auto context = std::make_shared<tuple_promise_context_t<
-                    std::tuple_element_t<Is, ResultTuple>...>>();
-                auto promises = std::make_tuple(make_tuple_sub_promise_impl<Is>(
-                    tuple,
-                    resolver,
-                    rejector,
-                    context)...);
-                (void)promises;
+                std::make_shared<context_t>(
+                    result,
+                    begin,
+                    end,
+                    max_in_flight,
+                    std::forward<F>(fn),
+                    std::move(inputs))->run();
             } catch (...) {
                 result.reject(std::current_exception());
             }
@@ -1429,13 +3872,56 @@ namespace promise_hpp
         }
     }
 
-    template < typename Tuple
-             , typename ResultTuple = impl::tuple_promise_result_t<std::decay_t<Tuple>> >
-    promise<ResultTuple>
-    make_tuple_promise(Tuple&& tuple) {
-        return impl::make_tuple_promise_impl(
-            std::forward<Tuple>(tuple),
-            std::make_index_sequence<std::tuple_size_v<ResultTuple>>());
+    // the range must stay alive until the result is settled, so must
+    // an lvalue container, an rvalue container is moved into the result
+
+    template < typename Iter, typename F >
+    auto map_concurrent(Iter begin, Iter end, std::size_t max_in_flight, F&& fn) {
+        return impl::make_map_promise(
+            begin,
+            end,
+            max_in_flight,
+            std::forward<F>(fn));
+    }
+
+    template < typename Container, typename F >
+    auto map_concurrent(Container&& container, std::size_t max_in_flight, F&& fn) {
+        if constexpr ( std::is_lvalue_reference_v<Container> ) {
+            return impl::make_map_promise(
+                std::begin(container),
+                std::end(container),
+                max_in_flight,
+                std::forward<F>(fn));
+        } else {
+            auto inputs = std::make_shared<Container>(std::move(container));
+            return impl::make_map_promise(
+                std::begin(*inputs),
+                std::end(*inputs),
+                max_in_flight,
+                std::forward<F>(fn),
+                inputs);
+        }
+    }
+
+    //
+    // map_sequential
+    //
+
+    template < typename Iter, typename F >
+    auto map_sequential(Iter begin, Iter end, F&& fn) {
+        return map_concurrent(
+            begin,
+            end,
+            1u,
+            std::forward<F>(fn));
+    }
+
+    template < typename Container, typename F >
+    auto map_sequential(Container&& container, F&& fn) {
+        return map_concurrent(
+            std::forward<Container>(container),
+            1u,
+            std::forward<F>(fn));
     }
 }
 
@@ -7,6 +7,8 @@
 #include <promise.hpp/bonus/jobber.hpp>
 #include <doctest/doctest.h>
 
+#include <set>
+#include <array>
 #include <thread>
 #include <numeric>
 #include <iostream>
@@ -328,4 +330,428 @@ TEST_CASE("jobber") {
         }
         REQUIRE(r0 == doctest::Approx(r1 * 50.0).epsilon(0.01));
     }
+    {
+        jb::jobber j(2);
+        std::atomic<int> counter = ATOMIC_VAR_INIT(0);
+        std::vector<jb::promise<void>> jp(50);
+        for ( auto& jpi : jp ) {
+            jpi = j.async([&counter](){
+                ++counter;
+            });
+        }
+        jb::make_all_promise(jp).get();
+        REQUIRE(counter == 50);
+    }
+    {
+        jb::jobber j(1);
+        std::atomic<int> counter = ATOMIC_VAR_INIT(0);
+        j.pause();
+        std::vector<jb::promise<void>> jp(10);
+        for ( auto& jpi : jp ) {
+            jpi = j.async([&counter](){
+                ++counter;
+            });
+        }
+        for ( std::size_t i = 0; i < jp.size(); i += 2 ) {
+            jp[i].cancel();
+        }
+        jp[1].then([](){}).cancel();
+        j.resume();
+        REQUIRE(j.wait_all() == jb::jobber_wait_status::no_timeout);
+        REQUIRE(counter == 4);
+        REQUIRE_THROWS_AS(jp[0].get(), jb::promise_cancelled_exception);
+        REQUIRE_THROWS_AS(jp[1].get(), jb::promise_cancelled_exception);
+        REQUIRE_NOTHROW(jp[3].get());
+    }
+    {
+        jb::jobber j(1);
+        j.pause();
+        std::vector<int> order;
+        for ( int i = 0; i < 100; ++i ) {
+            const auto priority = i % 2
+                ? jb::jobber_priority::highest
+                : jb::jobber_priority::lowest;
+            j.async(priority, [&order](int v){
+                order.push_back(v);
+            }, i);
+        }
+        j.resume();
+        REQUIRE(j.wait_all() == jb::jobber_wait_status::no_timeout);
+        REQUIRE(order.size() == 100u);
+        for ( std::size_t i = 0; i < 50; ++i ) {
+            REQUIRE(order[i] == static_cast<int>(i * 2 + 1));
+            REQUIRE(order[i + 50] == static_cast<int>(i * 2));
+        }
+    }
+    {
+        struct alignas(64) aligned_value {
+            int value{42};
+        };
+        jb::jobber j(2);
+        std::array<int, 100> big_value{};
+        big_value.fill(1);
+        auto p0 = j.async([big_value](){
+            return std::accumulate(big_value.begin(), big_value.end(), 0);
+        });
+        auto p1 = j.async([](const aligned_value& v){
+            REQUIRE(reinterpret_cast<std::uintptr_t>(&v) % alignof(aligned_value) == 0u);
+            return v.value;
+        }, aligned_value());
+        std::vector<jb::promise<int>> ps;
+        for ( int i = 0; i < 1000; ++i ) {
+            ps.push_back(j.async([i](){ return i; }));
+        }
+        REQUIRE(p0.get() == 100);
+        REQUIRE(p1.get() == 42);
+        REQUIRE(jb::make_all_promise(ps).get().back() == 999);
+    }
+    {
+        std::atomic<int> errors = ATOMIC_VAR_INIT(0);
+        jb::jobber_options options;
+        options.error_handler = [&errors](std::exception_ptr e){
+            try {
+                std::rethrow_exception(e);
+            } catch (std::logic_error&) {
+                ++errors;
+            }
+        };
+        jb::jobber j(2, options);
+        std::atomic<int> counter = ATOMIC_VAR_INIT(0);
+        for ( int i = 0; i < 100; ++i ) {
+            j.post([&counter](int v){
+                counter += v;
+                if ( v % 10 == 0 ) {
+                    throw std::logic_error("hello fail");
+                }
+            }, i);
+        }
+        REQUIRE(j.wait_all() == jb::jobber_wait_status::no_timeout);
+        REQUIRE(counter == 4950);
+        REQUIRE(errors == 10);
+    }
+    {
+        std::atomic<int> counter = ATOMIC_VAR_INIT(0);
+        {
+            jb::jobber j(1);
+            j.pause();
+            j.post(jb::jobber_priority::highest, [&counter](){ ++counter; });
+            j.post([](){ throw std::logic_error("hello fail"); });
+            REQUIRE(j.active_wait_all().second == 2u);
+            REQUIRE(counter == 1);
+            j.post([&counter](){ ++counter; });
+        }
+        REQUIRE(counter == 1);
+    }
+    {
+        jb::jobber j(4);
+        std::vector<int> values(1000);
+        std::iota(values.begin(), values.end(), 0);
+        auto ps = j.async_bulk(values.begin(), values.end(), [](int v){
+            return v * 2;
+        });
+        REQUIRE(ps.size() == 1000u);
+        std::vector<int> results = jb::make_all_promise(ps).get();
+        for ( std::size_t i = 0; i < results.size(); ++i ) {
+            REQUIRE(results[i] == static_cast<int>(i) * 2);
+        }
+        REQUIRE(j.async_bulk(values.begin(), values.begin(), [](int){}).empty());
+    }
+    {
+        jb::jobber j(1);
+        j.pause();
+        std::string accumulator;
+        std::vector<std::function<void()>> fs{
+            [&accumulator](){ accumulator.append("h"); },
+            [&accumulator](){ accumulator.append("e"); }};
+        std::vector<char> cs{'l', 'l', 'o'};
+        auto p0 = j.async_bulk(jb::jobber_priority::highest, fs.begin(), fs.end());
+        auto p1 = j.async_bulk(cs.begin(), cs.end(), [&accumulator](char c){
+            if ( c == 'o' ) {
+                throw std::logic_error("hello fail");
+            }
+            accumulator.push_back(c);
+        });
+        j.resume();
+        REQUIRE(j.wait_all() == jb::jobber_wait_status::no_timeout);
+        REQUIRE(accumulator == "hell");
+        REQUIRE_NOTHROW(p0[1].get());
+        REQUIRE_THROWS_AS(p1[2].get(), std::logic_error);
+    }
+    for ( bool work_stealing : {false, true} ) {
+        jb::jobber_options options;
+        options.work_stealing = work_stealing;
+        options.idle_strategy.spin_count = 1000u;
+        options.idle_strategy.yield_count = 10u;
+        jb::jobber j(2, options);
+        std::atomic<int> counter = ATOMIC_VAR_INIT(0);
+        for ( std::size_t i = 0; i < 100; ++i ) {
+            j.post([&counter](){ ++counter; });
+            if ( i % 10 == 0 ) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+        REQUIRE(j.wait_all() == jb::jobber_wait_status::no_timeout);
+        REQUIRE(counter == 100);
+        j.pause();
+        auto p = j.async([](){ return 42; });
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        REQUIRE(p.wait_for(std::chrono::milliseconds(0)) == jb::promise_wait_status::timeout);
+        j.resume();
+        REQUIRE(p.get() == 42);
+    }
+    {
+        const auto core_sets = jb::physical_core_cpu_sets();
+        const auto node_sets = jb::numa_node_cpu_sets();
+        std::set<std::size_t> core_cpus;
+        for ( const auto& cpus : core_sets ) {
+            REQUIRE_FALSE(cpus.empty());
+            for ( std::size_t cpu : cpus ) {
+                REQUIRE(core_cpus.insert(cpu).second);
+            }
+        }
+        for ( const auto& cpu_sets : {core_sets, node_sets, {{0u}, {0u, 1u}}} ) {
+            for ( bool work_stealing : {false, true} ) {
+                jb::jobber_options options;
+                options.work_stealing = work_stealing;
+                options.cpu_sets = cpu_sets;
+                jb::jobber j(4, options);
+                std::atomic<int> counter = ATOMIC_VAR_INIT(0);
+                for ( std::size_t i = 0; i < 10; ++i ) {
+                    j.async([&j, &counter](){
+                        for ( std::size_t k = 0; k < 10; ++k ) {
+                            j.post([&counter](){ ++counter; });
+                        }
+                    });
+                }
+                REQUIRE(j.wait_all() == jb::jobber_wait_status::no_timeout);
+                REQUIRE(counter == 100);
+            }
+        }
+    }
+#if defined(__linux__)
+    {
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        if ( 0 == sched_getaffinity(0, sizeof(allowed), &allowed) && CPU_ISSET(0, &allowed) ) {
+            for ( bool work_stealing : {false, true} ) {
+                jb::jobber_options options;
+                options.work_stealing = work_stealing;
+                options.cpu_sets = {{0u}};
+                jb::jobber j(4, options);
+                std::mutex mutex;
+                std::set<std::thread::id> pinned_ids;
+                std::atomic_size_t started{0u};
+                // every task waits for the others, so each worker runs one
+                for ( std::size_t i = 0; i < 4; ++i ) {
+                    j.post([&mutex, &pinned_ids, &started](){
+                        ++started;
+                        while ( started < 4u ) {
+                            std::this_thread::yield();
+                        }
+                        cpu_set_t set;
+                        CPU_ZERO(&set);
+                        if ( 0 == pthread_getaffinity_np(pthread_self(), sizeof(set), &set)
+                            && CPU_COUNT(&set) == 1 && CPU_ISSET(0, &set) )
+                        {
+                            std::lock_guard<std::mutex> guard(mutex);
+                            pinned_ids.insert(std::this_thread::get_id());
+                        }
+                    });
+                }
+                REQUIRE(j.wait_all() == jb::jobber_wait_status::no_timeout);
+                const std::vector<std::thread::id> ids = j.thread_ids();
+                REQUIRE(pinned_ids == std::set<std::thread::id>(ids.begin(), ids.end()));
+            }
+        }
+    }
+#endif
+    for ( bool work_stealing : {false, true} ) {
+        const auto eventually = [](auto&& pred){
+            for ( std::size_t i = 0; i < 5000 && !pred(); ++i ) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            return pred();
+        };
+        {
+            jb::jobber_options options;
+            options.work_stealing = work_stealing;
+            options.elasticity.max_threads = 4u;
+            jb::jobber j(2, options);
+            REQUIRE(j.thread_count() == 2u);
+            j.resize(4);
+            REQUIRE(j.thread_count() == 4u);
+            REQUIRE(j.thread_ids().size() == 4u);
+            REQUIRE(j.thread_id(3) != std::thread::id());
+            j.resize(1);
+            REQUIRE(eventually([&j](){ return j.thread_count() == 1u; }));
+            REQUIRE(j.async([](){ return 42; }).get() == 42);
+            j.resize(0);
+            REQUIRE(eventually([&j](){ return j.thread_count() == 0u; }));
+            auto p = j.async([](){ return 42; });
+            REQUIRE(j.active_wait_all() == jb::jobber::active_wait_result_t(
+                jb::jobber_wait_status::no_timeout, 1u));
+            REQUIRE(p.get() == 42);
+            j.resize(work_stealing ? 8 : 6);
+            REQUIRE(j.thread_count() == (work_stealing ? 4u : 6u));
+            REQUIRE(j.async([](){ return 42; }).get() == 42);
+        }
+        {
+            jb::jobber_options options;
+            options.work_stealing = work_stealing;
+            jb::jobber j(4, options);
+            std::atomic<bool> busy{true};
+            for ( std::size_t i = 0; i < 100000; ++i ) {
+                j.post([&busy](){
+                    if ( busy ) {
+                        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                    }
+                });
+            }
+            j.resize(1);
+            REQUIRE(eventually([&j](){ return j.thread_count() == 1u; }));
+            busy = false;
+            REQUIRE(j.wait_all() == jb::jobber_wait_status::no_timeout);
+        }
+        {
+            jb::jobber_options options;
+            options.work_stealing = work_stealing;
+            options.elasticity.max_threads = 3u;
+            options.elasticity.max_queue_delay = std::chrono::microseconds(0);
+            options.elasticity.idle_timeout = std::chrono::milliseconds(10);
+            jb::jobber j(1, options);
+            std::atomic<bool> blocked{true};
+            std::atomic<int> counter = ATOMIC_VAR_INIT(0);
+            auto blocker = [&blocked](){
+                while ( blocked ) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+            };
+            for ( std::size_t i = 0; i < 1000 && j.thread_count() < 3u; ++i ) {
+                j.post(blocker);
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            REQUIRE(j.thread_count() == 3u);
+            for ( std::size_t i = 0; i < 10; ++i ) {
+                j.post([&counter](){ ++counter; });
+            }
+            REQUIRE(j.thread_count() == 3u);
+            blocked = false;
+            REQUIRE(j.wait_all() == jb::jobber_wait_status::no_timeout);
+            REQUIRE(counter == 10);
+            REQUIRE(eventually([&j](){ return j.thread_count() == 1u; }));
+            REQUIRE(j.async([](){ return 42; }).get() == 42);
+        }
+    }
+}
+
+TEST_CASE("jobber_work_stealing") {
+    jb::jobber_options options;
+    options.work_stealing = true;
+    {
+        jb::jobber j(4, options);
+        std::atomic<int> counter = ATOMIC_VAR_INIT(0);
+        for ( std::size_t i = 0; i < 100; ++i ) {
+            j.async([&j, &counter](){
+                for ( std::size_t k = 0; k < 100; ++k ) {
+                    j.async([&counter](){
+                        ++counter;
+                    });
+                }
+                ++counter;
+            });
+        }
+        REQUIRE(j.wait_all() == jb::jobber_wait_status::no_timeout);
+        REQUIRE(counter == 10100);
+    }
+    {
+        jb::jobber j(4, options);
+        std::atomic<int> counter = ATOMIC_VAR_INIT(0);
+        std::vector<int> outer(10, 100);
+        auto ps = j.async_bulk(outer.begin(), outer.end(), [&j, &counter](int n){
+            std::vector<int> inner(static_cast<std::size_t>(n), 1);
+            return j.async_bulk(inner.begin(), inner.end(), [&counter](int v){
+                counter += v;
+            });
+        });
+        for ( auto& p : ps ) {
+            std::vector<jb::promise<void>> inner = p.get();
+            REQUIRE_NOTHROW(jb::make_all_promise(inner).get());
+        }
+        REQUIRE(counter == 1000);
+    }
+    {
+        jb::jobber j(2, options);
+        std::mutex ids_mutex;
+        std::set<std::thread::id> ids;
+        auto p = j.async([&j, &ids_mutex, &ids](){
+            std::vector<jb::promise<void>> children;
+            for ( std::size_t i = 0; i < 2; ++i ) {
+                children.push_back(j.async([&ids_mutex, &ids](){
+                    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                    std::lock_guard<std::mutex> guard(ids_mutex);
+                    ids.insert(std::this_thread::get_id());
+                }));
+            }
+            return children;
+        });
+        std::vector<jb::promise<void>> children = p.get();
+        REQUIRE_NOTHROW(jb::make_all_promise(children).get());
+        REQUIRE(ids.size() == 2);
+    }
+    {
+        jb::jobber j(1, options);
+        j.pause();
+        jb::jobber_priority max_priority = jb::jobber_priority::highest;
+        for ( std::size_t i = 0; i < 10; ++i ) {
+            jb::jobber_priority p = static_cast<jb::jobber_priority>(
+                i % static_cast<std::size_t>(jb::jobber_priority::highest));
+            j.async(p, [&max_priority](jb::jobber_priority priority) {
+                REQUIRE(priority <= max_priority);
+                max_priority = priority;
+            }, p);
+        }
+        j.resume();
+        REQUIRE(j.wait_all() == jb::jobber_wait_status::no_timeout);
+    }
+    {
+        std::atomic<int> counter = ATOMIC_VAR_INIT(0);
+        std::vector<jb::promise<void>> children;
+        {
+            jb::jobber j(1, options);
+            j.async([&j, &counter, &children](){
+                j.pause();
+                for ( std::size_t i = 0; i < 3; ++i ) {
+                    children.push_back(j.async([&counter](){
+                        ++counter;
+                    }));
+                }
+                children[0].cancel();
+            }).get();
+            auto r = j.active_wait_one();
+            REQUIRE(r.first == jb::jobber_wait_status::no_timeout);
+            REQUIRE(r.second == 1);
+            REQUIRE(counter == 1);
+        }
+        REQUIRE(counter == 1);
+        REQUIRE_THROWS_AS(children[0].get(), jb::promise_cancelled_exception);
+        REQUIRE_NOTHROW(children[1].get());
+        REQUIRE_THROWS_AS(children[2].get(), jb::jobber_cancelled_exception);
+    }
+    {
+        jb::jobber_options grouped_options = options;
+        grouped_options.cpu_sets = {{0u}};
+        jb::jobber j(2, grouped_options);
+        std::atomic<int> counter = ATOMIC_VAR_INIT(0);
+        j.async([&j, &counter](){
+            j.pause();
+            j.async([&counter](){
+                ++counter;
+            });
+        }).get();
+        auto r = j.active_wait_one();
+        REQUIRE(r.first == jb::jobber_wait_status::no_timeout);
+        REQUIRE(r.second == 1);
+        REQUIRE(counter == 1);
+        j.resume();
+    }
 }
@@ -0,0 +1,166 @@
+/*******************************************************************************
+ * This file is part of the "https://github.com/blackmatov/promise.hpp"
+ * For conditions of distribution and use, see copyright notice in LICENSE.md
+ * Copyright (C) 2018-2023, by Matvey Cherevko (blackmatov@gmail.com)
+ ******************************************************************************/
+
+#include <promise.hpp/bonus/parallel.hpp>
+#include <doctest/doctest.h>
+
+#include <random>
+#include <thread>
+#include <numeric>
+
+namespace pl = parallel_hpp;
+
+TEST_CASE("parallel") {
+    SUBCASE("parallel_for") {
+        {
+            pl::jobber j(4);
+            std::vector<int> vs(10000, 1);
+            auto p = pl::parallel_for(j, vs.begin(), vs.end(), [](int& v){
+                v *= 2;
+            });
+            REQUIRE_NOTHROW(pl::active_get(j, p));
+            REQUIRE(std::all_of(vs.begin(), vs.end(), [](int v){ return v == 2; }));
+        }
+        {
+            pl::jobber j(0);
+            std::vector<int> vs(100, 1);
+            auto p = pl::parallel_for(j, vs.begin(), vs.end(), [](int& v){
+                v += 1;
+            }, 7);
+            REQUIRE_NOTHROW(pl::active_get(j, p));
+            REQUIRE(std::all_of(vs.begin(), vs.end(), [](int v){ return v == 2; }));
+        }
+        {
+            pl::jobber j(2);
+            std::vector<int> vs;
+            auto p = pl::parallel_for(j, vs.begin(), vs.end(), [](int&){});
+            REQUIRE_NOTHROW(p.get());
+        }
+        {
+            pl::jobber j(2);
+            std::vector<int> vs(100, 1);
+            auto p = pl::parallel_for(j, vs.begin(), vs.end(), [](int v){
+                if ( v ) {
+                    throw std::logic_error("hello fail");
+                }
+            });
+            REQUIRE_THROWS_AS(pl::active_get(j, p), std::logic_error);
+        }
+        {
+            struct counter_t {
+                std::atomic<int>* calls;
+                void operator()(int& v) {
+                    v = ++*calls;
+                }
+            };
+            pl::jobber j(4);
+            std::atomic<int> calls = ATOMIC_VAR_INIT(0);
+            std::vector<int> vs(1000);
+            auto p = pl::parallel_for(j, vs.begin(), vs.end(), counter_t{&calls});
+            REQUIRE_NOTHROW(pl::active_get(j, p));
+            REQUIRE(calls == 1000);
+        }
+        {
+            pl::jobber j(1);
+            auto p = j.async([](){
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                return 42;
+            });
+            REQUIRE(pl::active_get(j, p) == 42);
+            REQUIRE(pl::active_get(j, p) == 42);
+        }
+    }
+    SUBCASE("parallel_transform") {
+        pl::jobber j(4);
+        std::vector<int> vs(10000);
+        std::iota(vs.begin(), vs.end(), 0);
+        std::vector<long long> rs(vs.size());
+        auto p = pl::parallel_transform(j, vs.begin(), vs.end(), rs.begin(), [](int v){
+            return static_cast<long long>(v) * v;
+        });
+        REQUIRE_NOTHROW(pl::active_get(j, p));
+        for ( std::size_t i = 0; i < rs.size(); ++i ) {
+            REQUIRE(rs[i] == static_cast<long long>(i) * static_cast<long long>(i));
+        }
+        struct offset_t {
+            long long offset;
+            long long operator()(int v) {
+                return v + offset;
+            }
+        };
+        auto p2 = pl::parallel_transform(j, vs.begin(), vs.end(), rs.begin(), offset_t{10});
+        REQUIRE_NOTHROW(pl::active_get(j, p2));
+        REQUIRE(rs.back() == static_cast<long long>(vs.back()) + 10);
+    }
+    SUBCASE("parallel_reduce") {
+        {
+            pl::jobber j(4);
+            std::vector<long long> vs(100000);
+            std::iota(vs.begin(), vs.end(), 1);
+            auto p = pl::parallel_reduce(j, vs.data(), vs.data() + vs.size(), 10ll);
+            REQUIRE(pl::active_get(j, p) == 100000ll * 100001ll / 2 + 10);
+        }
+        {
+            pl::jobber j(3);
+            std::vector<int> vs{3, 9, 2, 7, 5};
+            auto p = pl::parallel_reduce(j, vs.begin(), vs.end(), 0, [](int a, int b){
+                return std::max(a, b);
+            }, 1);
+            REQUIRE(p.get() == 9);
+        }
+        {
+            pl::jobber j(2);
+            std::vector<int> vs;
+            REQUIRE(pl::parallel_reduce(j, vs.begin(), vs.end(), 42).get() == 42);
+        }
+    }
+    SUBCASE("parallel_inclusive_scan") {
+        for ( std::size_t size : {0u, 1u, 5u, 1000u, 12345u} ) {
+            pl::jobber j(4);
+            std::vector<int> vs(size);
+            std::iota(vs.begin(), vs.end(), 0);
+            std::vector<int> rs(size);
+            std::vector<int> expected(size);
+            std::inclusive_scan(vs.begin(), vs.end(), expected.begin());
+            auto p = pl::parallel_inclusive_scan(j, vs.begin(), vs.end(), rs.begin());
+            REQUIRE_NOTHROW(pl::active_get(j, p));
+            REQUIRE(rs == expected);
+        }
+        {
+            pl::jobber j(2);
+            std::vector<int> vs(10, 2);
+            auto p = pl::parallel_inclusive_scan(j, vs.begin(), vs.end(), vs.begin(),
+                std::multiplies<>(), 3);
+            REQUIRE_NOTHROW(p.get());
+            REQUIRE(vs.back() == 1024);
+        }
+    }
+    SUBCASE("parallel_sort") {
+        std::mt19937 rng(42);
+        for ( std::size_t size : {0u, 1u, 2u, 17u, 1000u, 54321u} ) {
+            pl::jobber j(4);
+            std::vector<int> vs(size);
+            for ( int& v : vs ) {
+                v = static_cast<int>(rng() % 1000u);
+            }
+            std::vector<int> expected = vs;
+            std::sort(expected.begin(), expected.end(), std::greater<>());
+            auto p = pl::parallel_sort(j, vs.begin(), vs.end(), std::greater<>());
+            REQUIRE_NOTHROW(pl::active_get(j, p));
+            REQUIRE(vs == expected);
+        }
+        {
+            pl::jobber_options options;
+            options.work_stealing = true;
+            pl::jobber j(4, options);
+            std::vector<int> vs(10000);
+            std::iota(vs.rbegin(), vs.rend(), 0);
+            auto p = pl::parallel_sort(j, vs.begin(), vs.end(), std::less<>(), 3);
+            REQUIRE_NOTHROW(pl::active_get(j, p));
+            REQUIRE(std::is_sorted(vs.begin(), vs.end()));
+        }
+    }
+}
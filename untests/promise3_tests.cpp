@@ -112,7 +112,7 @@ TEST_CASE("promise3") {
 
             int call_then_only_once = 0;
             pr::make_all_promise(std::array<pr::promise<int>, 2>{p1, p2})
-            .then([&call_then_only_once](const std::vector<int>& c){
+            .then([&call_then_only_once](const std::array<int, 2>& c){
                 (void)c;
                 ++call_then_only_once;
             });
@@ -122,6 +122,132 @@ TEST_CASE("promise3") {
 
             REQUIRE(call_then_only_once == 1);
         }
+        {
+            auto p = pr::make_all_promise(std::array<pr::promise<int>, 0>{});
+            static_assert(
+                std::is_same<decltype(p), pr::promise<std::array<int, 0>>>::value,
+                "unit test fail");
+            REQUIRE(p.get().empty());
+        }
+        {
+            const std::array<pr::promise<int>, 3> ps{};
+            auto p = pr::make_all_promise(ps);
+            static_assert(
+                std::is_same<decltype(p), pr::promise<std::array<int, 3>>>::value,
+                "unit test fail");
+            pr::promise<int>(ps[2]).resolve(3);
+            pr::promise<int>(ps[0]).resolve(1);
+            REQUIRE(p.wait_for(std::chrono::milliseconds(0)) == pr::promise_wait_status::timeout);
+            pr::promise<int>(ps[1]).resolve(2);
+            REQUIRE(p.get() == std::array<int, 3>{1, 2, 3});
+        }
+        {
+            std::array<pr::promise<void>, 2> ps{};
+            auto p = pr::make_all_promise(ps);
+            static_assert(
+                std::is_same<decltype(p), pr::promise<void>>::value,
+                "unit test fail");
+            ps[0].resolve();
+            ps[1].reject(std::logic_error("hello fail"));
+            REQUIRE_THROWS_AS(p.get(), std::logic_error);
+        }
+        {
+            std::vector<pr::promise<int>> ps(1000);
+            auto p = pr::make_all_promise(ps);
+            for ( std::size_t i = ps.size(); i > 0; --i ) {
+                ps[i - 1].resolve(static_cast<int>(i - 1));
+            }
+            const std::vector<int>& c = p.get();
+            REQUIRE(c.size() == 1000);
+            std::vector<int> e(1000);
+            std::iota(e.begin(), e.end(), 0);
+            REQUIRE(c == e);
+        }
+        {
+            std::vector<pr::promise<int>> ps(10000);
+            auto p = pr::make_all_promise(ps);
+            std::vector<std::thread> ts;
+            for ( std::size_t t = 0; t < 4; ++t ) {
+                ts.emplace_back([&ps, t](){
+                    for ( std::size_t i = t; i < ps.size(); i += 4 ) {
+                        ps[i].resolve(static_cast<int>(i));
+                    }
+                });
+            }
+            for ( auto& t : ts ) {
+                t.join();
+            }
+            std::vector<int> e(10000);
+            std::iota(e.begin(), e.end(), 0);
+            REQUIRE(p.get() == e);
+        }
+        {
+            pr::detail::sharded_countdown c{5000};
+            std::size_t zero_count = 0;
+            for ( std::size_t i = 0; i < 5000; ++i ) {
+                if ( c.count_down(i) ) {
+                    ++zero_count;
+                    REQUIRE(i == 4999);
+                }
+            }
+            REQUIRE(zero_count == 1);
+        }
+        {
+            auto p1 = pr::promise<bool>();
+            auto p2 = pr::promise<bool>();
+            auto p3 = pr::make_all_promise(std::vector<pr::promise<bool>>{p1, p2});
+            p2.resolve(true);
+            p1.resolve(false);
+            REQUIRE(p3.get() == std::vector<bool>{false, true});
+        }
+        {
+            class o_t {
+            public:
+                o_t() = delete;
+                o_t(int i) : i_(i) {}
+                int get() const { return i_; }
+            private:
+                int i_;
+            };
+
+            auto p1 = pr::promise<o_t>();
+            auto p2 = pr::promise<o_t>();
+            auto p3 = pr::make_all_promise(std::vector<pr::promise<o_t>>{p1, p2});
+            p2.resolve(o_t(2));
+            p1.resolve(o_t(40));
+            REQUIRE(p3.get().size() == 2);
+            REQUIRE(p3.get()[0].get() == 40);
+            REQUIRE(p3.get()[1].get() == 2);
+        }
+        {
+            auto p = pr::make_all_promise(std::vector<pr::promise<void>>());
+            static_assert(
+                std::is_same<decltype(p), pr::promise<void>>::value,
+                "unit test fail");
+            REQUIRE_NOTHROW(p.get());
+        }
+        {
+            auto p1 = pr::promise<void>();
+            auto p2 = pr::promise<void>();
+
+            int call_then_only_once = 0;
+            pr::make_all_promise(std::vector<pr::promise<void>>{p1, p2})
+            .then([&call_then_only_once](){
+                ++call_then_only_once;
+            });
+
+            p1.resolve();
+            REQUIRE(call_then_only_once == 0);
+            p2.resolve();
+            REQUIRE(call_then_only_once == 1);
+        }
+        {
+            auto p1 = pr::promise<void>();
+            auto p2 = pr::promise<void>();
+            auto p3 = pr::make_all_promise(std::vector<pr::promise<void>>{p1, p2});
+            p2.reject(std::logic_error("hello fail"));
+            REQUIRE_THROWS_AS(p3.get(), std::logic_error);
+        }
         {
             class o_t {
             public:
@@ -273,6 +399,99 @@ TEST_CASE("promise3") {
             });
         }
     }
+    SUBCASE("make_quorum_promise") {
+        {
+            auto p = pr::make_quorum_promise(std::vector<pr::promise<int>>{}, 0);
+            REQUIRE(p.get().empty());
+        }
+        {
+            bool all_is_ok = false;
+            auto p = pr::make_quorum_promise(std::vector<pr::promise<int>>{
+                pr::make_resolved_promise(32)}, 2);
+            p.except([&all_is_ok](std::exception_ptr e){
+                all_is_ok = check_empty_aggregate_exception(e);
+                return std::vector<int>();
+            });
+            REQUIRE(all_is_ok);
+        }
+        {
+            auto p1 = pr::promise<int>();
+            auto p2 = pr::promise<int>();
+            auto p3 = pr::promise<int>();
+            auto p = pr::make_quorum_promise(std::vector<pr::promise<int>>{p1, p2, p3}, 2);
+            p3.resolve(30);
+            p2.reject(std::logic_error("hello fail"));
+            REQUIRE(p.wait_for(std::chrono::milliseconds(0)) == pr::promise_wait_status::timeout);
+            p1.resolve(10);
+            REQUIRE(p.get() == std::vector<int>{30, 10});
+        }
+        {
+            std::weak_ptr<int> context;
+            auto p1 = pr::promise<int>();
+            auto p2 = pr::promise<int>();
+            auto slow = pr::promise<int>();
+            {
+                auto data = std::make_shared<int>(42);
+                context = data;
+                auto p = pr::make_quorum_promise(std::vector<pr::promise<int>>{
+                    p1.then([data](int v){ return v + *data; }),
+                    p2,
+                    slow}, 2);
+                p2.resolve(2);
+                p1.resolve(1);
+                REQUIRE(p.get() == std::vector<int>{2, 43});
+            }
+            REQUIRE(context.expired());
+        }
+        {
+            bool all_is_ok = false;
+            auto p1 = pr::promise<void>();
+            auto p2 = pr::promise<void>();
+            auto p3 = pr::promise<void>();
+            auto p = pr::make_quorum_promise(std::vector<pr::promise<void>>{p1, p2, p3}, 2);
+            p1.reject(std::logic_error("hello fail"));
+            p3.reject(std::logic_error("hello fail"));
+            p.except([&all_is_ok](std::exception_ptr e){
+                try {
+                    std::rethrow_exception(e);
+                } catch (pr::aggregate_exception& ee) {
+                    all_is_ok = ee.size() == 3
+                        && check_hello_fail_exception(ee[0])
+                        && !ee[1]
+                        && check_hello_fail_exception(ee[2]);
+                }
+            });
+            REQUIRE(all_is_ok);
+            REQUIRE(p2.resolve());
+        }
+        {
+            auto p = pr::make_quorum_promise(std::vector<pr::promise<void>>{
+                pr::make_resolved_promise(),
+                pr::make_rejected_promise<void>(std::logic_error("hello fail")),
+                pr::make_resolved_promise()}, 2);
+            REQUIRE_NOTHROW(p.get());
+        }
+        {
+            std::vector<pr::promise<int>> ps(100);
+            auto p = pr::make_quorum_promise(ps, 51);
+            std::vector<std::thread> threads;
+            for ( std::size_t t = 0; t < 4; ++t ) {
+                threads.emplace_back([&ps, t](){
+                    for ( std::size_t i = t; i < ps.size(); i += 4 ) {
+                        if ( i % 2 ) {
+                            ps[i].reject(std::logic_error("hello fail"));
+                        } else {
+                            ps[i].resolve(static_cast<int>(i));
+                        }
+                    }
+                });
+            }
+            for ( std::thread& t : threads ) {
+                t.join();
+            }
+            REQUIRE_THROWS_AS(p.get(), pr::aggregate_exception);
+        }
+    }
     SUBCASE("make_tuple_promise") {
         {
             static_assert(
@@ -354,6 +573,134 @@ TEST_CASE("promise3") {
                 REQUIRE(&std::get<1>(t) == &f);
             });
         }
+        {
+            static_assert(
+                std::is_same<
+                    pr::impl::tuple_promise_result_t<std::tuple<pr::promise<void>, pr::promise<void>>>,
+                    void>::value,
+                "unit test fail");
+
+            auto p1 = pr::promise<void>();
+            auto p2 = pr::promise<void>();
+            auto p3 = pr::make_tuple_promise(std::make_tuple(p1, p2));
+            static_assert(
+                std::is_same<decltype(p3), pr::promise<void>>::value,
+                "unit test fail");
+
+            p2.resolve();
+            REQUIRE(p3.wait_for(std::chrono::milliseconds(0)) == pr::promise_wait_status::timeout);
+            p1.resolve();
+            REQUIRE_NOTHROW(p3.get());
+        }
+        {
+            auto p1 = pr::promise<void>();
+            auto p2 = pr::promise<void>();
+            auto p3 = pr::make_tuple_promise(std::make_tuple(p1, p2));
+            p1.reject(std::logic_error("hello fail"));
+            REQUIRE_THROWS_AS(p3.get(), std::logic_error);
+        }
+    }
+    SUBCASE("when_all") {
+        {
+            auto p = pr::when_all();
+            REQUIRE(p.get() == std::make_tuple());
+        }
+        {
+            auto p1 = pr::promise<int>();
+            auto p2 = pr::promise<float>();
+            auto p3 = pr::when_all(p1, p2);
+            static_assert(
+                std::is_same<decltype(p3), pr::promise<std::tuple<int, float>>>::value,
+                "unit test fail");
+            p2.resolve(4.2f);
+            REQUIRE(p3.wait_for(std::chrono::milliseconds(0)) == pr::promise_wait_status::timeout);
+            p1.resolve(42);
+            REQUIRE(p3.get() == std::make_tuple(42, 4.2f));
+        }
+        {
+            auto p1 = pr::promise<void>();
+            auto p2 = pr::promise<void>();
+            auto p3 = pr::when_all(p1, p2);
+            static_assert(
+                std::is_same<decltype(p3), pr::promise<void>>::value,
+                "unit test fail");
+            p1.resolve();
+            p2.resolve();
+            REQUIRE_NOTHROW(p3.get());
+        }
+        {
+            auto p1 = pr::promise<int>();
+            auto p2 = pr::promise<float>();
+            auto p3 = pr::when_all(p1, p2);
+            p2.reject(std::logic_error("hello fail"));
+            REQUIRE_THROWS_AS(p3.get(), std::logic_error);
+        }
+    }
+    SUBCASE("make_all_settled_promise") {
+        {
+            auto p = pr::make_all_settled_promise(std::vector<pr::promise<int>>());
+            REQUIRE(p.get().empty());
+        }
+        {
+            auto p1 = pr::promise<int>();
+            auto p2 = pr::promise<int>();
+            auto p3 = pr::promise<int>();
+            auto p4 = pr::make_all_settled_promise(std::vector<pr::promise<int>>{p1, p2, p3});
+
+            p3.resolve(84);
+            p2.reject(std::logic_error("hello fail"));
+            REQUIRE(p4.wait_for(std::chrono::milliseconds(0)) == pr::promise_wait_status::timeout);
+            p1.resolve(42);
+
+            const auto& r = p4.get();
+            REQUIRE(r.size() == 3);
+            REQUIRE(r[0].is_resolved());
+            REQUIRE(r[0].value() == 42);
+            REQUIRE_FALSE(r[0].exception());
+            REQUIRE(r[1].is_rejected());
+            REQUIRE(check_hello_fail_exception(r[1].exception()));
+            REQUIRE_THROWS_AS(r[1].value(), std::logic_error);
+            REQUIRE(r[2].is_resolved());
+            REQUIRE(r[2].value() == 84);
+        }
+        {
+            auto p1 = pr::promise<void>();
+            auto p2 = pr::promise<void>();
+            auto p3 = pr::make_all_settled_promise(std::vector<pr::promise<void>>{p1, p2});
+
+            p1.reject(std::logic_error("hello fail"));
+            p2.resolve();
+
+            const auto& r = p3.get();
+            REQUIRE(r.size() == 2);
+            REQUIRE(r[0].is_rejected());
+            REQUIRE(check_hello_fail_exception(r[0].exception()));
+            REQUIRE(r[1].is_resolved());
+            REQUIRE_NOTHROW(r[1].value());
+        }
+    }
+    SUBCASE("make_tuple_settled_promise") {
+        {
+            auto p = pr::make_tuple_settled_promise(std::make_tuple());
+            REQUIRE(p.get() == std::make_tuple());
+        }
+        {
+            auto p1 = pr::promise<int>();
+            auto p2 = pr::promise<void>();
+            auto p3 = pr::promise<float>();
+            auto p4 = pr::make_tuple_settled_promise(std::make_tuple(p1, p2, p3));
+
+            p3.reject(std::logic_error("hello fail"));
+            p2.resolve();
+            REQUIRE(p4.wait_for(std::chrono::milliseconds(0)) == pr::promise_wait_status::timeout);
+            p1.resolve(42);
+
+            const auto& r = p4.get();
+            REQUIRE(std::get<0>(r).value() == 42);
+            REQUIRE(std::get<1>(r).is_resolved());
+            REQUIRE(std::get<2>(r).is_rejected());
+            REQUIRE(check_hello_fail_exception(std::get<2>(r).exception()));
+        }
     }
     SUBCASE("make_all_promise_fail") {
         {
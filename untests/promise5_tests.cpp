@@ -0,0 +1,677 @@
+/*******************************************************************************
+ * This file is part of the "https://github.com/blackmatov/promise.hpp"
+ * For conditions of distribution and use, see copyright notice in LICENSE.md
+ * Copyright (C) 2018-2023, by Matvey Cherevko (blackmatov@gmail.com)
+ ******************************************************************************/
+
+#include <promise.hpp/promise.hpp>
+#include <doctest/doctest.h>
+
+#include <array>
+#include <thread>
+#include <numeric>
+#include <cstring>
+
+namespace pr = promise_hpp;
+
+namespace
+{
+    bool check_cancelled_exception(std::exception_ptr e) {
+        try {
+            std::rethrow_exception(e);
+        } catch (pr::promise_cancelled_exception&) {
+            return true;
+        } catch (...) {
+            return false;
+        }
+    }
+}
+
+TEST_CASE("cancellation") {
+    SUBCASE("cancel") {
+        {
+            auto p = pr::promise<int>();
+            REQUIRE_FALSE(p.is_cancelled());
+            REQUIRE(p.cancel());
+            REQUIRE(p.is_cancelled());
+            REQUIRE_FALSE(p.cancel());
+            REQUIRE_FALSE(p.resolve(42));
+            REQUIRE_FALSE(p.reject(std::logic_error("hello fail")));
+            REQUIRE_THROWS_AS(p.get(), pr::promise_cancelled_exception);
+        }
+        {
+            auto p = pr::promise<void>();
+            REQUIRE(p.cancel());
+            REQUIRE(p.is_cancelled());
+            REQUIRE_FALSE(p.resolve());
+            REQUIRE_THROWS_AS(p.get(), pr::promise_cancelled_exception);
+        }
+        {
+            auto p = pr::make_resolved_promise(42);
+            REQUIRE_FALSE(p.cancel());
+            REQUIRE_FALSE(p.is_cancelled());
+            REQUIRE(p.get() == 42);
+        }
+        {
+            bool call_except = false;
+            auto p = pr::promise<int>();
+            p.then([](int){
+                REQUIRE(false);
+            }).except([&call_except](std::exception_ptr e){
+                call_except = check_cancelled_exception(e);
+            });
+            p.cancel();
+            REQUIRE(call_except);
+        }
+    }
+    SUBCASE("upstream") {
+        {
+            auto p1 = pr::promise<int>();
+            auto p2 = p1.then([](int v){ return v * 2; });
+            auto p3 = p2.then([](int v){ return v * 2; });
+            REQUIRE(p3.cancel());
+            REQUIRE(p2.is_cancelled());
+            REQUIRE(p1.is_cancelled());
+        }
+        {
+            auto p1 = pr::promise<void>();
+            auto p2 = p1.then([](){});
+            auto p3 = p1.then([](){});
+            REQUIRE(p2.cancel());
+            REQUIRE_FALSE(p1.is_cancelled());
+            REQUIRE(p3.cancel());
+            REQUIRE(p1.is_cancelled());
+        }
+        {
+            auto p1 = pr::promise<int>();
+            auto p2 = p1.then([](int v){ return v * 2; });
+            p1.resolve(21);
+            REQUIRE_FALSE(p2.cancel());
+            REQUIRE(p2.get() == 42);
+        }
+        {
+            auto p1 = pr::promise<int>();
+            auto p2 = p1.then([](int v){
+                return pr::make_resolved_promise(v * 2);
+            });
+            REQUIRE(p2.cancel());
+            REQUIRE(p1.is_cancelled());
+        }
+        {
+            auto p1 = pr::promise<int>();
+            auto p2 = pr::promise<int>();
+            auto p3 = p1.then([&p2](int){
+                return p2;
+            });
+            p1.resolve(42);
+            REQUIRE(p3.cancel());
+            REQUIRE(p2.is_cancelled());
+        }
+        {
+            auto p = pr::promise<int>();
+            auto all = pr::make_all_promise(std::vector<pr::promise<int>>{p});
+            REQUIRE(p.then([](int v){ return v; }).cancel());
+            REQUIRE_FALSE(p.is_cancelled());
+            REQUIRE(p.resolve(42));
+            REQUIRE(all.get() == std::vector<int>{42});
+        }
+        {
+            auto p = pr::promise<void>();
+            auto s = p.subscribe([](){}, [](std::exception_ptr){});
+            REQUIRE(p.then([](){}).cancel());
+            REQUIRE_FALSE(p.is_cancelled());
+            REQUIRE(s.unsubscribe());
+            REQUIRE(p.is_cancelled());
+        }
+        {
+            auto p = pr::promise<int>();
+            auto s = p.subscribe([](int){}, [](std::exception_ptr){});
+            REQUIRE(p.then([](int){}).cancel());
+            auto p2 = p.then([](int v){ return v; });
+            REQUIRE(s.unsubscribe());
+            REQUIRE_FALSE(p.is_cancelled());
+            REQUIRE(p.resolve(42));
+            REQUIRE(p2.get() == 42);
+        }
+    }
+    SUBCASE("cancellation_token") {
+        {
+            pr::cancellation_token t;
+            REQUIRE_FALSE(t.can_be_cancelled());
+            REQUIRE_FALSE(t.is_cancelled());
+        }
+        {
+            pr::cancellation_source s;
+            auto t = s.token();
+            REQUIRE(t.can_be_cancelled());
+
+            auto p1 = pr::promise<int>().cancel_on(t);
+            auto p2 = pr::promise<void>().cancel_on(t);
+            auto p3 = pr::make_resolved_promise(42).cancel_on(t);
+
+            REQUIRE(s.cancel());
+            REQUIRE_FALSE(s.cancel());
+            REQUIRE(s.is_cancelled());
+            REQUIRE(t.is_cancelled());
+
+            REQUIRE(p1.is_cancelled());
+            REQUIRE(p2.is_cancelled());
+            REQUIRE(p3.get() == 42);
+        }
+        {
+            pr::cancellation_source s;
+            s.cancel();
+            bool call_on_cancel = false;
+            s.token().on_cancel([&call_on_cancel](){
+                call_on_cancel = true;
+            });
+            REQUIRE(call_on_cancel);
+            REQUIRE(pr::promise<int>().cancel_on(s.token()).is_cancelled());
+        }
+    }
+}
+
+TEST_CASE("subscription") {
+    SUBCASE("unsubscribe") {
+        {
+            int call_count = 0;
+            auto p = pr::promise<int>();
+            auto s1 = p.subscribe([&call_count](int v){
+                call_count += v;
+            }, [](std::exception_ptr){});
+            auto s2 = p.subscribe([&call_count](int v){
+                call_count += v * 10;
+            }, [](std::exception_ptr){});
+            REQUIRE(s1.unsubscribe());
+            REQUIRE_FALSE(s1.unsubscribe());
+            p.resolve(4);
+            REQUIRE(call_count == 40);
+            REQUIRE_FALSE(s2.unsubscribe());
+        }
+        {
+            bool call_fail = false;
+            auto p = pr::promise<void>();
+            auto s = p.subscribe([](){}, [&call_fail](std::exception_ptr){
+                call_fail = true;
+            });
+            auto s2 = std::move(s);
+            REQUIRE_FALSE(s.unsubscribe());
+            REQUIRE(s2.unsubscribe());
+            p.reject(std::logic_error("hello fail"));
+            REQUIRE_FALSE(call_fail);
+        }
+        {
+            bool call_resolve = false;
+            auto p = pr::make_resolved_promise(42);
+            auto s = p.subscribe([&call_resolve](int v){
+                call_resolve = v == 42;
+            }, [](std::exception_ptr){});
+            REQUIRE(call_resolve);
+            REQUIRE_FALSE(s.unsubscribe());
+            REQUIRE_FALSE(pr::promise_subscription().unsubscribe());
+        }
+        {
+            auto p = pr::promise<int>();
+            for ( std::size_t i = 0; i < 1000; ++i ) {
+                p.subscribe([](int){
+                    REQUIRE(false);
+                }, [](std::exception_ptr){
+                    REQUIRE(false);
+                }).unsubscribe();
+            }
+            int call_count = 0;
+            p.subscribe([&call_count](int){
+                ++call_count;
+            }, [](std::exception_ptr){});
+            p.resolve(42);
+            REQUIRE(call_count == 1);
+        }
+    }
+    SUBCASE("subscribe_in_handler") {
+        int call_count = 0;
+        auto p = pr::promise<int>();
+        p.then([&call_count, &p](int){
+            p.then([&call_count](int){
+                ++call_count;
+            });
+            ++call_count;
+        });
+        p.resolve(42);
+        REQUIRE(call_count == 2);
+    }
+    SUBCASE("race_detach") {
+        {
+            std::weak_ptr<int> context;
+            auto signal = pr::promise<int>();
+            for ( std::size_t i = 0; i < 10; ++i ) {
+                auto data = std::make_shared<int>(42);
+                context = data;
+                auto timeout = pr::promise<int>();
+                auto r = pr::make_race_promise(std::vector<pr::promise<int>>{
+                    signal,
+                    timeout.then([data](int v){ return v + *data; })});
+                timeout.resolve(1);
+                REQUIRE(r.get() == 43);
+            }
+            REQUIRE(context.expired());
+            signal.resolve(0);
+        }
+        {
+            std::weak_ptr<int> context;
+            auto signal = pr::promise<void>();
+            {
+                auto data = std::make_shared<int>(42);
+                context = data;
+                auto p = pr::promise<void>();
+                auto r = pr::make_race_promise(std::vector<pr::promise<void>>{
+                    signal,
+                    p.then([data](){})});
+                p.reject(std::logic_error("hello fail"));
+                REQUIRE_THROWS_AS(r.get(), std::logic_error);
+            }
+            REQUIRE(context.expired());
+        }
+        {
+            auto p = pr::promise<int>();
+            auto r = pr::make_race_promise(std::vector<pr::promise<int>>{p, p});
+            p.resolve(42);
+            REQUIRE(r.get() == 42);
+        }
+    }
+    SUBCASE("any_detach") {
+        std::weak_ptr<int> context;
+        auto signal = pr::promise<int>();
+        {
+            auto data = std::make_shared<int>(42);
+            context = data;
+            auto p1 = pr::promise<int>();
+            auto p2 = pr::promise<int>();
+            auto r = pr::make_any_promise(std::vector<pr::promise<int>>{
+                signal,
+                p1.then([data](int v){ return v + *data; }),
+                p2});
+            p2.reject(std::logic_error("hello fail"));
+            p1.resolve(1);
+            REQUIRE(r.get() == 43);
+        }
+        REQUIRE(context.expired());
+    }
+}
+
+TEST_CASE("loops") {
+    SUBCASE("promise_while") {
+        {
+            std::size_t counter = 0;
+            auto p = pr::promise_while([&counter](){
+                return counter < 1000000;
+            }, [&counter](){
+                ++counter;
+                return pr::make_resolved_promise();
+            });
+            REQUIRE_NOTHROW(p.get());
+            REQUIRE(counter == 1000000);
+        }
+        {
+            std::size_t counter = 0;
+            std::vector<pr::promise<int>> ps(100);
+            auto p = pr::promise_while([&counter, &ps](){
+                return counter < ps.size();
+            }, [&counter, &ps](){
+                return ps[counter++];
+            });
+            std::thread t([&ps](){
+                for ( std::size_t i = 0; i < ps.size(); ++i ) {
+                    ps[i].resolve(static_cast<int>(i));
+                }
+            });
+            t.join();
+            REQUIRE_NOTHROW(p.get());
+            REQUIRE(counter == 100);
+        }
+        {
+            std::size_t counter = 0;
+            auto p = pr::promise_while([](){
+                return true;
+            }, [&counter](){
+                return ++counter < 10
+                    ? pr::make_resolved_promise()
+                    : pr::make_rejected_promise<void>(std::logic_error("hello fail"));
+            });
+            REQUIRE_THROWS_AS(p.get(), std::logic_error);
+            REQUIRE(counter == 10);
+        }
+        {
+            auto p = pr::promise_while([]() -> bool {
+                throw std::logic_error("hello fail");
+            }, [](){
+                return pr::make_resolved_promise();
+            });
+            REQUIRE_THROWS_AS(p.get(), std::logic_error);
+        }
+        {
+            std::size_t counter = 0;
+            auto next = pr::promise<void>();
+            auto p = pr::promise_while([](){
+                return true;
+            }, [&counter, &next](){
+                ++counter;
+                next = pr::promise<void>();
+                return next;
+            });
+            next.resolve();
+            next.resolve();
+            REQUIRE(counter == 3);
+            REQUIRE(p.cancel());
+            next.resolve();
+            REQUIRE(counter == 3);
+        }
+    }
+    SUBCASE("repeat_until") {
+        {
+            int counter = 0;
+            auto p = pr::repeat_until([&counter](){
+                return pr::make_resolved_promise(++counter);
+            }, [](int v){
+                return v == 1000000;
+            });
+            REQUIRE(p.get() == 1000000);
+        }
+        {
+            std::size_t counter = 0;
+            std::vector<pr::promise<int>> ps(100);
+            auto p = pr::repeat_until([&counter, &ps](){
+                return ps[counter++];
+            }, [](int v){
+                return v >= 50;
+            });
+            std::thread t([&ps](){
+                for ( std::size_t i = 0; i < ps.size(); ++i ) {
+                    ps[i].resolve(static_cast<int>(i));
+                }
+            });
+            t.join();
+            REQUIRE(p.get() == 50);
+            REQUIRE(counter == 51);
+        }
+        {
+            int counter = 0;
+            auto p = pr::repeat_until([&counter](){
+                ++counter;
+                return pr::make_resolved_promise();
+            }, [&counter](){
+                return counter == 10;
+            });
+            REQUIRE_NOTHROW(p.get());
+            REQUIRE(counter == 10);
+        }
+        {
+            auto p = pr::repeat_until([](){
+                return pr::make_resolved_promise(42);
+            }, [](int) -> bool {
+                throw std::logic_error("hello fail");
+            });
+            REQUIRE_THROWS_AS(p.get(), std::logic_error);
+        }
+    }
+}
+
+TEST_CASE("map") {
+    SUBCASE("map_concurrent") {
+        {
+            auto p = pr::map_concurrent(std::vector<int>{}, 4, [](int v){
+                return pr::make_resolved_promise(v);
+            });
+            REQUIRE(p.get().empty());
+        }
+        {
+            std::vector<int> inputs(100000);
+            std::iota(inputs.begin(), inputs.end(), 0);
+            auto p = pr::map_concurrent(inputs.begin(), inputs.end(), 8, [](int v){
+                return pr::make_resolved_promise(v * 2);
+            });
+            const std::vector<int>& results = p.get();
+            REQUIRE(results.size() == 100000);
+            for ( std::size_t i = 0; i < results.size(); ++i ) {
+                REQUIRE(results[i] == static_cast<int>(i * 2));
+            }
+        }
+        {
+            std::size_t in_flight = 0;
+            std::size_t max_in_flight = 0;
+            std::vector<pr::promise<int>> ps(20);
+            auto p = pr::map_concurrent(std::vector<std::size_t>{
+                0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19
+            }, 3, [&ps, &in_flight, &max_in_flight](std::size_t i){
+                max_in_flight = std::max(max_in_flight, ++in_flight);
+                return ps[i].then([&in_flight](int v){
+                    --in_flight;
+                    return v;
+                });
+            });
+            REQUIRE(in_flight == 3);
+            for ( std::size_t i = ps.size(); i > 0; --i ) {
+                ps[i - 1].resolve(static_cast<int>(i - 1));
+            }
+            for ( std::size_t i = 0; i < ps.size(); ++i ) {
+                ps[i].resolve(static_cast<int>(i));
+            }
+            const std::vector<int>& results = p.get();
+            REQUIRE(max_in_flight == 3);
+            for ( std::size_t i = 0; i < results.size(); ++i ) {
+                REQUIRE(results[i] == static_cast<int>(i));
+            }
+        }
+        {
+            std::size_t launched = 0;
+            std::vector<pr::promise<void>> ps(10);
+            auto p = pr::map_concurrent(std::vector<std::size_t>{0, 1, 2, 3, 4, 5, 6, 7, 8, 9}, 2,
+            [&ps, &launched](std::size_t i){
+                ++launched;
+                return ps[i];
+            });
+            ps[0].resolve();
+            ps[1].reject(std::logic_error("hello fail"));
+            ps[2].resolve();
+            REQUIRE_THROWS_AS(p.get(), std::logic_error);
+            REQUIRE(launched == 3);
+        }
+        {
+            std::atomic_size_t counter{0};
+            std::vector<pr::promise<void>> ps(1000);
+            auto p = pr::map_concurrent(ps.begin(), ps.end(), 16, [&counter](pr::promise<void>& sp){
+                ++counter;
+                return sp;
+            });
+            std::vector<std::thread> threads;
+            for ( std::size_t t = 0; t < 4; ++t ) {
+                threads.emplace_back([&ps, t](){
+                    for ( std::size_t i = t; i < ps.size(); i += 4 ) {
+                        ps[i].resolve();
+                    }
+                });
+            }
+            for ( std::thread& t : threads ) {
+                t.join();
+            }
+            REQUIRE_NOTHROW(p.get());
+            REQUIRE(counter == 1000);
+        }
+        {
+            std::vector<int> inputs{1, 2, 3};
+            auto p = pr::map_concurrent(inputs, 2, [&inputs](int& v){
+                REQUIRE(&v >= inputs.data());
+                REQUIRE(&v < inputs.data() + inputs.size());
+                return pr::make_resolved_promise(v * 2);
+            });
+            REQUIRE(p.get() == std::vector<int>{2, 4, 6});
+        }
+    }
+    SUBCASE("map_sequential") {
+        {
+            std::vector<std::string> order;
+            auto p = pr::map_sequential(std::vector<std::string>{"a", "b", "c"},
+            [&order](const std::string& s){
+                order.push_back(s);
+                return pr::make_resolved_promise(s + s);
+            });
+            REQUIRE(p.get() == std::vector<std::string>{"aa", "bb", "cc"});
+            REQUIRE(order == std::vector<std::string>{"a", "b", "c"});
+        }
+        {
+            std::size_t launched = 0;
+            std::vector<pr::promise<int>> ps(3);
+            auto p = pr::map_sequential(ps.begin(), ps.end(), [&launched](pr::promise<int>& sp){
+                ++launched;
+                return sp;
+            });
+            REQUIRE(launched == 1);
+            ps[0].resolve(1);
+            REQUIRE(launched == 2);
+            ps[1].resolve(2);
+            ps[2].resolve(3);
+            REQUIRE(p.get() == std::vector<int>{1, 2, 3});
+        }
+        {
+            auto p = pr::map_sequential(std::vector<int>{1, 2}, [](int v){
+                return pr::make_resolved_promise(v == 1);
+            });
+            REQUIRE(p.get() == std::vector<bool>{true, false});
+        }
+    }
+}
+
+TEST_CASE("as_completed") {
+    SUBCASE("for_each_as_completed") {
+        {
+            std::vector<std::size_t> order;
+            std::vector<pr::promise<int>> ps(3);
+            auto p = pr::for_each_as_completed(ps, [&order](std::size_t i, pr::settled_result<int> r){
+                REQUIRE(r.is_resolved());
+                REQUIRE(r.value() == static_cast<int>(i) * 10);
+                order.push_back(i);
+            });
+            ps[2].resolve(20);
+            ps[0].resolve(0);
+            REQUIRE(order == std::vector<std::size_t>{2, 0});
+            REQUIRE(p.wait_for(std::chrono::milliseconds(0)) == pr::promise_wait_status::timeout);
+            ps[1].resolve(10);
+            REQUIRE(order == std::vector<std::size_t>{2, 0, 1});
+            REQUIRE_NOTHROW(p.get());
+        }
+        {
+            std::size_t rejected = 0;
+            std::vector<pr::promise<void>> ps(2);
+            auto p = pr::for_each_as_completed(ps, [&rejected](std::size_t, pr::settled_result<void> r){
+                rejected += r.is_rejected() ? 1 : 0;
+            });
+            ps[0].reject(std::logic_error("hello fail"));
+            ps[1].resolve();
+            REQUIRE_NOTHROW(p.get());
+            REQUIRE(rejected == 1);
+        }
+        {
+            std::size_t calls = 0;
+            std::vector<pr::promise<int>> ps(3);
+            auto p = pr::for_each_as_completed(ps, [&calls](std::size_t, pr::settled_result<int>){
+                ++calls;
+                throw std::logic_error("hello fail");
+            });
+            ps[0].resolve(1);
+            REQUIRE_THROWS_AS(p.get(), std::logic_error);
+            ps[1].resolve(2);
+            ps[2].resolve(3);
+            REQUIRE(calls == 1);
+        }
+        {
+            std::size_t calls = 0;
+            std::vector<pr::promise<int>> ps(3);
+            auto p = pr::for_each_as_completed(ps, [&calls](std::size_t, pr::settled_result<int>){
+                ++calls;
+            });
+            ps[0].resolve(1);
+            REQUIRE(p.cancel());
+            ps[1].resolve(2);
+            ps[2].resolve(3);
+            REQUIRE(calls == 1);
+            REQUIRE_THROWS_AS(p.get(), pr::promise_cancelled_exception);
+        }
+        {
+            std::vector<pr::promise<int>> ps;
+            auto p = pr::for_each_as_completed(ps, [](std::size_t, pr::settled_result<int>){});
+            REQUIRE_NOTHROW(p.get());
+        }
+        {
+            std::atomic_size_t calls{0u};
+            std::atomic_bool inside{false};
+            std::atomic_bool reentered{false};
+            std::vector<pr::promise<int>> ps(1000);
+            auto p = pr::for_each_as_completed(ps.begin(), ps.end(),
+            [&calls, &inside, &reentered](std::size_t, pr::settled_result<int>){
+                if ( inside.exchange(true) ) {
+                    reentered = true;
+                }
+                ++calls;
+                inside = false;
+            });
+            std::vector<std::thread> threads;
+            for ( std::size_t t = 0; t < 4; ++t ) {
+                threads.emplace_back([&ps, t](){
+                    for ( std::size_t i = t; i < ps.size(); i += 4 ) {
+                        ps[i].resolve(static_cast<int>(i));
+                    }
+                });
+            }
+            for ( std::thread& t : threads ) {
+                t.join();
+            }
+            REQUIRE_NOTHROW(p.get());
+            REQUIRE(calls == 1000u);
+            REQUIRE_FALSE(reentered);
+        }
+    }
+    SUBCASE("as_completed_queue") {
+        {
+            std::vector<pr::promise<int>> ps(3);
+            auto q = pr::as_completed(ps);
+            REQUIRE(q.size() == 3);
+            REQUIRE(q.remaining() == 3);
+            ps[1].resolve(42);
+            auto n0 = q.next();
+            REQUIRE(n0.get().first == 1);
+            REQUIRE(n0.get().second.value() == 42);
+            auto n1 = q.next();
+            REQUIRE(n1.wait_for(std::chrono::milliseconds(0)) == pr::promise_wait_status::timeout);
+            ps[2].reject(std::logic_error("hello fail"));
+            REQUIRE(n1.get().first == 2);
+            REQUIRE(n1.get().second.is_rejected());
+            auto n2 = q.next();
+            REQUIRE(q.empty());
+            ps[0].resolve(84);
+            REQUIRE(n2.get().first == 0);
+            REQUIRE(n2.get().second.value() == 84);
+            REQUIRE_THROWS_AS(q.next().get(), std::out_of_range);
+        }
+        {
+            std::vector<pr::promise<void>> ps(2);
+            auto q = pr::as_completed(ps.begin(), ps.end());
+            auto n0 = q.next();
+            auto n1 = q.next();
+            ps[1].resolve();
+            ps[0].resolve();
+            REQUIRE(n0.get().first == 1);
+            REQUIRE(n1.get().first == 0);
+            REQUIRE(n1.get().second.is_resolved());
+        }
+        {
+            std::vector<pr::promise<int>> ps(3);
+            auto q = pr::as_completed(ps);
+            ps[2].resolve(2);
+            ps[0].resolve(0);
+            ps[1].resolve(1);
+            REQUIRE(q.next().get().first == 2);
+            REQUIRE(q.next().get().first == 0);
+            REQUIRE(q.next().get().first == 1);
+            REQUIRE(q.empty());
+        }
+    }
+}
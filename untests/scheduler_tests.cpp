@@ -174,4 +174,64 @@ TEST_CASE("scheduler") {
             std::size_t(5u)));
         REQUIRE(accumulator == "hello");
     }
+    {
+        sd::scheduler s;
+        int counter = 0;
+        sd::cancellation_source cs;
+        s.schedule([&counter](){ ++counter; });
+        s.schedule([&counter](){ ++counter; }).cancel_on(cs.token());
+        s.schedule([&counter](){ ++counter; }).cancel();
+        cs.cancel();
+        REQUIRE(s.process_all_tasks() == std::make_pair(
+            sd::scheduler_processing_status::done,
+            std::size_t(1u)));
+        REQUIRE(counter == 1);
+    }
+    {
+        sd::scheduler s;
+        std::vector<int> order;
+        for ( int i = 0; i < 100; ++i ) {
+            const auto priority = i % 2
+                ? sd::scheduler_priority::highest
+                : sd::scheduler_priority::lowest;
+            s.schedule(priority, [&order](int v){
+                order.push_back(v);
+            }, i);
+        }
+        REQUIRE(s.process_all_tasks() == std::make_pair(
+            sd::scheduler_processing_status::done,
+            std::size_t(100u)));
+        REQUIRE(order.size() == 100u);
+        for ( std::size_t i = 0; i < 50; ++i ) {
+            REQUIRE(order[i] == static_cast<int>(i * 2 + 1));
+            REQUIRE(order[i + 50] == static_cast<int>(i * 2));
+        }
+    }
+    {
+        std::vector<std::string> errors;
+        sd::scheduler s([&errors](std::exception_ptr e){
+            try {
+                std::rethrow_exception(e);
+            } catch (std::exception& ee) {
+                errors.push_back(ee.what());
+            }
+        });
+        int counter = 0;
+        s.post([&counter](){ ++counter; });
+        s.post(sd::scheduler_priority::highest, [&counter](int v){
+            REQUIRE(counter == 0);
+            counter += v;
+        }, 10);
+        s.post([](){ throw std::logic_error("hello fail"); });
+        REQUIRE(s.process_all_tasks() == std::make_pair(
+            sd::scheduler_processing_status::done,
+            std::size_t(3u)));
+        REQUIRE(counter == 11);
+        REQUIRE(errors == std::vector<std::string>{"hello fail"});
+    }
+    {
+        sd::scheduler s;
+        s.post([](){ throw std::logic_error("hello fail"); });
+        REQUIRE(s.process_all_tasks().second == 1u);
+    }
 }
@@ -0,0 +1,389 @@
+/*******************************************************************************
+ * This file is part of the "https://github.com/blackmatov/promise.hpp"
+ * For conditions of distribution and use, see copyright notice in LICENSE.md
+ * Copyright (C) 2018-2023, by Matvey Cherevko (blackmatov@gmail.com)
+ ******************************************************************************/
+
+#include <promise.hpp/bonus/timer.hpp>
+#include <doctest/doctest.h>
+
+#include <thread>
+#include <numeric>
+
+namespace ti = timer_hpp;
+
+TEST_CASE("timer") {
+    const auto eventually = [](auto&& pred){
+        for ( std::size_t i = 0; i < 5000 && !pred(); ++i ) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return pred();
+    };
+    SUBCASE("timer_wheel") {
+        {
+            std::atomic_int counter{0};
+            ti::timer_wheel w;
+            w.schedule_after(std::chrono::milliseconds(5), [&counter](){
+                ++counter;
+            });
+            w.schedule_after(std::chrono::milliseconds(10), [&counter](){
+                counter += 10;
+            });
+            auto id = w.schedule_after(std::chrono::milliseconds(15), [&counter](){
+                counter += 100;
+            });
+            w.schedule_after(std::chrono::milliseconds(20), [&counter](){
+                counter += 1000;
+            });
+            REQUIRE(w.timer_count() == 4);
+            REQUIRE(w.cancel(id));
+            REQUIRE_FALSE(w.cancel(id));
+            REQUIRE(w.timer_count() == 3);
+            REQUIRE(eventually([&w](){ return w.timer_count() == 0; }));
+            REQUIRE(eventually([&counter](){ return counter >= 1000; }));
+            REQUIRE(counter == 1011);
+            REQUIRE_FALSE(w.cancel(id));
+            REQUIRE_FALSE(w.cancel(ti::timer_wheel::timer_id()));
+        }
+        {
+            ti::timer_wheel w;
+            w.schedule_after(std::chrono::seconds(100), [](){});
+            REQUIRE_FALSE(w.cancel(ti::timer_wheel::timer_id()));
+            REQUIRE(w.timer_count() == 1);
+        }
+        {
+            std::atomic_int counter{0};
+            ti::timer_wheel w;
+            for ( std::size_t i = 0; i < 100; ++i ) {
+                w.schedule_after(std::chrono::milliseconds(i % 7), [&counter](){
+                    ++counter;
+                });
+            }
+            for ( std::size_t i = 0; i < 100; ++i ) {
+                auto id = w.schedule_after(std::chrono::seconds(100), [&counter](){
+                    ++counter;
+                });
+                if ( i % 2 ) {
+                    REQUIRE(w.cancel(id));
+                }
+            }
+            REQUIRE(eventually([&counter](){ return counter == 100; }));
+            REQUIRE(eventually([&w](){ return w.timer_count() == 50; }));
+        }
+        {
+            std::atomic_int counter{0};
+            std::atomic<ti::timer_wheel::clock_type::duration::rep> fire_delay{0};
+            const auto start = ti::timer_wheel::clock_type::now();
+            ti::timer_wheel w{std::chrono::microseconds(100)};
+            w.schedule_after(std::chrono::milliseconds(10), [&counter, &fire_delay, start](){
+                fire_delay = (ti::timer_wheel::clock_type::now() - start).count();
+                ++counter;
+            });
+            REQUIRE(eventually([&counter](){ return counter == 1; }));
+            REQUIRE(ti::timer_wheel::clock_type::duration(fire_delay) >= std::chrono::milliseconds(10));
+        }
+        {
+            std::atomic_int counter{0};
+            ti::timer_wheel w;
+            w.schedule_after(std::chrono::hours(100), [&counter](){
+                ++counter;
+            });
+        }
+        {
+            std::atomic_int counter{0};
+            ti::timer_wheel w;
+            w.schedule_after(std::chrono::hours(1), [&counter](){
+                counter += 100;
+            });
+            // lets the wheel go to sleep until the far timer first
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            const auto start = ti::timer_wheel::clock_type::now();
+            w.schedule_after(std::chrono::milliseconds(300), [&counter](){
+                ++counter;
+            });
+            w.schedule_after(std::chrono::milliseconds(10), [&counter](){
+                ++counter;
+            });
+            REQUIRE(eventually([&counter](){ return counter == 1; }));
+            REQUIRE(eventually([&counter](){ return counter == 2; }));
+            REQUIRE(ti::timer_wheel::clock_type::now() - start >= std::chrono::milliseconds(300));
+            REQUIRE(eventually([&w](){ return w.timer_count() == 1; }));
+        }
+    }
+    SUBCASE("with_timeout") {
+        {
+            auto p = ti::promise<int>();
+            auto r = ti::with_timeout(p, std::chrono::milliseconds(10));
+            REQUIRE(r.wait_for(std::chrono::seconds(5)) == ti::promise_wait_status::no_timeout);
+            REQUIRE_THROWS_AS(r.get(), ti::timeout_exception);
+            REQUIRE(p.resolve(42));
+        }
+        {
+            ti::timer_wheel w;
+            auto p = ti::promise<int>();
+            auto r = ti::with_timeout(p, std::chrono::seconds(100), w);
+            REQUIRE(w.timer_count() == 1);
+            p.resolve(42);
+            REQUIRE(r.get() == 42);
+            REQUIRE(w.timer_count() == 0);
+        }
+        {
+            ti::timer_wheel w;
+            auto p = ti::promise<void>();
+            auto r = ti::with_timeout(p, std::chrono::seconds(100), w);
+            p.reject(std::logic_error("hello fail"));
+            REQUIRE_THROWS_AS(r.get(), std::logic_error);
+            REQUIRE(w.timer_count() == 0);
+        }
+        {
+            ti::timer_wheel w;
+            auto r = ti::with_timeout(ti::make_resolved_promise(42), std::chrono::seconds(100), w);
+            REQUIRE(r.get() == 42);
+            REQUIRE(w.timer_count() == 0);
+        }
+        {
+            ti::timer_wheel w;
+            auto p = ti::promise<int>();
+            auto r = ti::with_timeout(p, std::chrono::milliseconds(5), w);
+            REQUIRE_THROWS_AS(r.get(), ti::timeout_exception);
+            REQUIRE(w.timer_count() == 0);
+            REQUIRE(p.resolve(42));
+            REQUIRE_THROWS_AS(r.get(), ti::timeout_exception);
+        }
+        {
+            ti::timer_wheel w;
+            bool call_resolve = false;
+            auto p = ti::promise<int>();
+            auto r = ti::with_timeout(p, std::chrono::seconds(100), w);
+            r.then([&call_resolve](int){
+                call_resolve = true;
+            });
+            REQUIRE(w.timer_count() == 1);
+            REQUIRE(r.cancel());
+            REQUIRE(w.timer_count() == 0);
+            REQUIRE(p.resolve(42));
+            REQUIRE_FALSE(call_resolve);
+            REQUIRE_THROWS_AS(r.get(), ti::promise_cancelled_exception);
+        }
+        {
+            ti::timer_wheel w;
+            auto p = ti::promise<void>();
+            auto r = ti::with_timeout(p, std::chrono::seconds(100), w);
+            REQUIRE(r.then([](){}).cancel());
+            REQUIRE(r.is_cancelled());
+            REQUIRE(w.timer_count() == 0);
+        }
+    }
+    SUBCASE("with_deadline") {
+        ti::timer_wheel w;
+        std::vector<ti::promise<int>> ps(1000);
+        std::vector<ti::promise<int>> rs;
+        for ( std::size_t i = 0; i < ps.size(); ++i ) {
+            rs.push_back(ti::with_deadline(
+                ps[i],
+                ti::timer_wheel::clock_type::now() + std::chrono::milliseconds(i % 2 ? 10 : 100000),
+                w));
+        }
+        for ( std::size_t i = 0; i < ps.size(); i += 2 ) {
+            ps[i].resolve(static_cast<int>(i));
+        }
+        for ( std::size_t i = 0; i < rs.size(); ++i ) {
+            if ( i % 2 ) {
+                REQUIRE_THROWS_AS(rs[i].get(), ti::timeout_exception);
+            } else {
+                REQUIRE(rs[i].get() == static_cast<int>(i));
+            }
+        }
+        REQUIRE(w.timer_count() == 0);
+    }
+    SUBCASE("make_hedged_promise") {
+        {
+            std::atomic_size_t attempts{0u};
+            std::atomic_bool passed{false};
+            std::vector<ti::promise<int>> ps(3);
+            ti::timer_wheel w;
+            auto r = ti::make_hedged_promise([&attempts, &ps](){
+                return ps[attempts++];
+            }, std::chrono::milliseconds(50), 3, w);
+            REQUIRE(attempts == 1u);
+            REQUIRE(eventually([&attempts](){ return attempts == 2u; }));
+            ps[1].resolve(42);
+            REQUIRE(r.get() == 42);
+            REQUIRE(w.timer_count() == 0);
+            // the wheel fires in order, so once this one has fired the
+            // cancelled third attempt would have been launched too
+            w.schedule_after(std::chrono::milliseconds(100), [&passed](){
+                passed = true;
+            });
+            REQUIRE(eventually([&passed](){ return passed.load(); }));
+            REQUIRE(attempts == 2u);
+            ps[0].resolve(84);
+            REQUIRE(r.get() == 42);
+        }
+        {
+            std::atomic_size_t attempts{0u};
+            ti::timer_wheel w;
+            auto r = ti::make_hedged_promise([&attempts](){
+                ++attempts;
+                return ti::make_resolved_promise(42);
+            }, std::chrono::milliseconds(5), 3, w);
+            REQUIRE(r.get() == 42);
+            REQUIRE(attempts == 1u);
+            REQUIRE(w.timer_count() == 0);
+        }
+        {
+            std::atomic_size_t attempts{0u};
+            ti::timer_wheel w;
+            auto r = ti::make_hedged_promise([&attempts]() -> ti::promise<void> {
+                if ( attempts++ < 2u ) {
+                    throw std::logic_error("hello fail");
+                }
+                return ti::make_resolved_promise();
+            }, std::chrono::seconds(100), 3, w);
+            REQUIRE_NOTHROW(r.get());
+            REQUIRE(attempts == 3u);
+            REQUIRE(w.timer_count() == 0);
+        }
+        {
+            ti::timer_wheel w;
+            auto r = ti::make_hedged_promise([](){
+                return ti::make_rejected_promise<int>(std::logic_error("hello fail"));
+            }, std::chrono::seconds(100), 3, w);
+            REQUIRE_THROWS_AS(r.get(), ti::aggregate_exception);
+            try {
+                r.get();
+            } catch (ti::aggregate_exception& e) {
+                REQUIRE(e.size() == 3);
+            }
+        }
+        {
+            auto r = ti::make_hedged_promise([](){
+                return ti::promise<int>();
+            }, std::chrono::seconds(100), 0);
+            REQUIRE_THROWS_AS(r.get(), ti::aggregate_exception);
+        }
+        {
+            std::atomic_size_t attempts{0u};
+            std::vector<ti::promise<int>> ps(2);
+            ti::timer_wheel w;
+            auto r = ti::make_hedged_promise([&attempts, &ps](){
+                const std::size_t attempt = attempts++;
+                if ( attempt ) {
+                    ps[0].resolve(42);
+                }
+                return ps[attempt];
+            }, std::chrono::milliseconds(5), 2, w);
+            REQUIRE(r.wait_for(std::chrono::seconds(5)) == ti::promise_wait_status::no_timeout);
+            REQUIRE(r.get() == 42);
+            REQUIRE(attempts == 2u);
+        }
+        {
+            std::atomic_size_t attempts{0u};
+            std::atomic_bool passed{false};
+            ti::timer_wheel w;
+            auto r = ti::make_hedged_promise([&attempts](){
+                ++attempts;
+                return ti::promise<int>();
+            }, std::chrono::milliseconds(50), 100, w);
+            REQUIRE(r.cancel());
+            REQUIRE(w.timer_count() == 0);
+            w.schedule_after(std::chrono::milliseconds(100), [&passed](){
+                passed = true;
+            });
+            REQUIRE(eventually([&passed](){ return passed.load(); }));
+            REQUIRE(attempts == 1u);
+            REQUIRE_THROWS_AS(r.get(), ti::promise_cancelled_exception);
+        }
+    }
+    SUBCASE("retry") {
+        {
+            std::atomic_size_t attempts{0u};
+            ti::timer_wheel w;
+            ti::retry_policy policy;
+            policy.max_attempts = 5;
+            policy.initial_delay = std::chrono::milliseconds(1);
+            auto r = ti::retry([&attempts](){
+                if ( ++attempts < 3u ) {
+                    return ti::make_rejected_promise<int>(std::logic_error("hello fail"));
+                }
+                return ti::make_resolved_promise(42);
+            }, policy, w);
+            REQUIRE(r.get() == 42);
+            REQUIRE(attempts == 3u);
+        }
+        {
+            std::atomic_size_t attempts{0u};
+            ti::timer_wheel w;
+            ti::retry_policy policy;
+            policy.initial_delay = std::chrono::milliseconds(1);
+            auto r = ti::retry([&attempts]() -> ti::promise<void> {
+                ++attempts;
+                throw std::logic_error("hello fail");
+            }, policy, w);
+            REQUIRE_THROWS_AS(r.get(), std::logic_error);
+            REQUIRE(attempts == 3u);
+        }
+        {
+            std::atomic_size_t attempts{0u};
+            ti::timer_wheel w;
+            ti::retry_policy policy;
+            policy.max_attempts = 10;
+            policy.initial_delay = std::chrono::milliseconds(1);
+            policy.retryable = [](std::exception_ptr e){
+                try {
+                    std::rethrow_exception(e);
+                } catch (std::logic_error&) {
+                    return true;
+                } catch (...) {
+                    return false;
+                }
+            };
+            auto r = ti::retry([&attempts](){
+                return ++attempts < 2u
+                    ? ti::make_rejected_promise<int>(std::logic_error("hello fail"))
+                    : ti::make_rejected_promise<int>(std::runtime_error("hello fail"));
+            }, policy, w);
+            REQUIRE_THROWS_AS(r.get(), std::runtime_error);
+            REQUIRE(attempts == 2u);
+        }
+        {
+            std::atomic_size_t attempts{0u};
+            ti::timer_wheel w;
+            ti::retry_policy policy;
+            policy.initial_delay = std::chrono::milliseconds(20);
+            policy.jitter = 0.0;
+            const auto start = ti::timer_wheel::clock_type::now();
+            auto r = ti::retry([&attempts](){
+                return ++attempts < 3u
+                    ? ti::make_rejected_promise<int>(std::logic_error("hello fail"))
+                    : ti::make_resolved_promise(42);
+            }, policy, w);
+            REQUIRE(r.get() == 42);
+            REQUIRE(ti::timer_wheel::clock_type::now() - start >= std::chrono::milliseconds(60));
+        }
+        {
+            std::atomic_size_t attempts{0u};
+            ti::timer_wheel w;
+            ti::retry_policy policy;
+            policy.initial_delay = std::chrono::milliseconds(20);
+            auto r = ti::retry([&attempts](){
+                ++attempts;
+                return ti::make_rejected_promise<int>(std::logic_error("hello fail"));
+            }, policy, w);
+            REQUIRE(r.cancel());
+            REQUIRE(eventually([&w](){ return w.timer_count() == 0; }));
+            REQUIRE(attempts == 1u);
+        }
+        {
+            std::size_t attempts = 0u;
+            ti::retry_policy policy;
+            policy.max_attempts = 0;
+            auto r = ti::retry([&attempts](){
+                ++attempts;
+                return ti::make_resolved_promise(42);
+            }, policy);
+            REQUIRE_THROWS_AS(r.get(), ti::aggregate_exception);
+            REQUIRE(attempts == 0u);
+        }
+    }
+}